@@ -19,6 +19,8 @@
     MA 02110-1301 USA.
 */
 
+#include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
@@ -27,18 +29,23 @@
 #include "data.h"
 #include "error.h"
 #include "sysfs.h"
-
-/* We watch the recursion depth for variables only, as an easy way to
-   detect cycles. */
-#define DEPTH_MAX	8
+#include "general.h"
+#include "shm.h"
+#include "rolling.h"
+#include "stats.h"
+#include "probes.h"
+#include "virtual.h"
 
 static int sensors_eval_expr(const sensors_chip_features *chip_features,
-			     const sensors_expr *expr,
-			     double val, int depth, double *result);
+			     const sensors_expr *expr, double val,
+			     const sensors_eval_vars *vars, int max_age,
+			     double *result);
+
+SENSORS_PROBE_DEFINE(compute);
 
 /* Compare two chips name descriptions, to see whether they could match.
    Return 0 if it does not match, return 1 if it does match. */
-static int sensors_match_chip(const sensors_chip_name *chip1,
+int sensors_match_chip(const sensors_chip_name *chip1,
 		       const sensors_chip_name *chip2)
 {
 	if ((chip1->prefix != SENSORS_CHIP_NAME_PREFIX_ANY) &&
@@ -90,14 +97,57 @@ sensors_for_all_config_chips(const sensors_chip_name *name,
 	return NULL;
 }
 
+sensors_chip_state *sensors_new_chip_state(void)
+{
+	sensors_chip_state *state;
+	pthread_mutexattr_t attr;
+
+	state = calloc(1, sizeof(sensors_chip_state));
+	if (!state)
+		sensors_fatal_error(__func__, "Out of memory");
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&state->lock, &attr);
+	pthread_mutexattr_destroy(&attr);
+	return state;
+}
+
+void sensors_free_chip_state(sensors_chip_state *state)
+{
+	if (!state)
+		return;
+	pthread_mutex_destroy(&state->lock);
+	free(state);
+}
+
+void sensors_lock_chip(const sensors_chip_features *chip)
+{
+	pthread_mutex_lock(&chip->state->lock);
+}
+
+void sensors_unlock_chip(const sensors_chip_features *chip)
+{
+	pthread_mutex_unlock(&chip->state->lock);
+}
+
 /* Look up a chip in the intern chip list, and return a pointer to it.
    Do not modify the struct the return value points to! Returns NULL if
    not found.*/
-static const sensors_chip_features *
+const sensors_chip_features *
 sensors_lookup_chip(const sensors_chip_name *name)
 {
+	uintptr_t offset;
 	int i;
 
+	/* Names returned by sensors_get_detected_chips() point into the
+	   chip list, no need to search for them */
+	offset = (uintptr_t)name - (uintptr_t)sensors_proc_chips;
+	if (offset < sensors_proc_chips_count * sizeof(sensors_chip_features) &&
+	    offset % sizeof(sensors_chip_features) ==
+	    offsetof(sensors_chip_features, chip))
+		return &sensors_proc_chips[offset /
+					   sizeof(sensors_chip_features)];
+
 	for (i = 0; i < sensors_proc_chips_count; i++)
 		if (sensors_match_chip(&sensors_proc_chips[i].chip, name))
 			return &sensors_proc_chips[i];
@@ -118,22 +168,10 @@ sensors_lookup_subfeature_nr(const sensors_chip_features *chip,
 	return chip->subfeature + subfeat_nr;
 }
 
-/* Look up a feature of the given chip, and return a pointer to it.
-   Do not modify the struct the return value points to! Returns NULL if
-   not found.*/
-static const sensors_feature *
-sensors_lookup_feature_nr(const sensors_chip_features *chip, int feat_nr)
-{
-	if (feat_nr < 0 ||
-	    feat_nr >= chip->feature_count)
-		return NULL;
-	return chip->feature + feat_nr;
-}
-
 /* Look up a subfeature by name, and return a pointer to it.
    Do not modify the struct the return value points to! Returns NULL if 
    not found.*/
-static const sensors_subfeature *
+const sensors_subfeature *
 sensors_lookup_subfeature_name(const sensors_chip_features *chip,
 			       const char *name)
 {
@@ -159,6 +197,15 @@ int sensors_chip_name_has_wildcards(const sensors_chip_name *chip)
 		return 0;
 }
 
+/* Check whether a subfeature is an alarm flag. Returns 1 if it is, 0
+   if not. Fault and beep flags are not alarms. */
+int sensors_subfeature_is_alarm(const sensors_subfeature *subfeature)
+{
+	size_t len = strlen(subfeature->name);
+
+	return len >= 5 && !strcmp(subfeature->name + len - 5, "alarm");
+}
+
 /* Look up the label for a given feature. Note that chip should not
    contain wildcard values! The returned string is newly allocated (free it
    yourself). On failure, NULL is returned.
@@ -182,10 +229,15 @@ char *sensors_get_label(const sensors_chip_name *name,
 				goto sensors_get_label_exit;
 			}
 
-	/* No user specified label, check for a _label sysfs file */
-	snprintf(buf, PATH_MAX, "%s/%s_label", name->path, feature->name);
-	
-	if ((f = fopen(buf, "r"))) {
+	/* No user specified label, check for a _label sysfs file. Virtual
+	   chips have no sysfs files. */
+	f = NULL;
+	if (name->path) {
+		snprintf(buf, PATH_MAX, "%s/%s_label", name->path,
+			 feature->name);
+		f = fopen(buf, "r");
+	}
+	if (f) {
 		i = fread(buf, 1, sizeof(buf), f);
 		fclose(f);
 		if (i > 0) {
@@ -221,20 +273,269 @@ static int sensors_get_ignored(const sensors_chip_name *name,
 	return 0;
 }
 
+/* A chip with option quarantine is quarantined after that many
+   consecutive slow reads, and probed again after a delay, doubling after
+   each slow probe */
+#define QUARANTINE_FAILURES	3
+#define QUARANTINE_SLOW_MS	250
+#define QUARANTINE_BACKOFF_MIN	1000
+#define QUARANTINE_BACKOFF_MAX	(5 * 60 * 1000)
+
+/* Check whether the device of a chip is runtime suspended, in which case
+   reading from the chip would wake it up. Reading the status itself
+   doesn't. Returns 1 if it is suspended, 0 if not or if we can't tell. */
+static int sensors_chip_suspended(const sensors_chip_features *chip_features)
+{
+	char buf[16];
+	FILE *f;
+	int suspended = 0;
+
+	if (!(f = fopen(chip_features->pm_path, "r")))
+		return 0;
+	if (fgets(buf, sizeof(buf), f))
+		suspended = !strncmp(buf, "suspend", 7);
+	fclose(f);
+	return suspended;
+}
+
+/* Check whether a chip may be read now. Returns 0 and the start time of
+   the read in nanoseconds if so, <0 if not. */
+static int sensors_chip_attr_begin(const sensors_chip_features *chip_features,
+				   long long *start)
+{
+	const sensors_chip_state *state = chip_features->state;
+
+	if (chip_features->no_wakeup && chip_features->pm_path &&
+	    sensors_chip_suspended(chip_features))
+		return -SENSORS_ERR_SUSPENDED;
+
+	*start = sensors_get_time_ns();
+	if (state->backoff && *start / 1000000 < state->retry)
+		return -SENSORS_ERR_QUARANTINE;
+	return 0;
+}
+
+/* Account for the outcome of a read in the chip health, and in the read
+   statistics if enabled */
+static void sensors_chip_attr_end(const sensors_chip_features *chip_features,
+				  int subfeat_nr, int res, long long start)
+{
+	sensors_chip_state *state = chip_features->state;
+	long long now;
+	int elapsed;
+
+	now = sensors_get_time_ns();
+	if (chip_features->stats)
+		sensors_stats_account(&chip_features->stats[subfeat_nr], res,
+				      now - start);
+	elapsed = (now - start) / 1000;
+	if (state->latency)
+		state->latency += (elapsed - state->latency) / 8;
+	else
+		state->latency = elapsed;
+
+	if (!chip_features->quarantine)
+		return;
+	/* Errors alone don't tell a bus in trouble: some attributes of
+	   healthy chips always fail, such as those of disconnected inputs,
+	   but they fail fast */
+	if (elapsed > QUARANTINE_SLOW_MS * 1000) {
+		state->failures++;
+		if (state->backoff) {	/* Failed probe */
+			state->backoff *= 2;
+			if (state->backoff > QUARANTINE_BACKOFF_MAX)
+				state->backoff = QUARANTINE_BACKOFF_MAX;
+		} else if (state->failures >= QUARANTINE_FAILURES) {
+			state->backoff = QUARANTINE_BACKOFF_MIN;
+		}
+		state->retry = now / 1000000 + state->backoff;
+	} else {
+		state->failures = 0;
+		state->backoff = 0;
+	}
+}
+
+int sensors_read_chip_attr(const sensors_chip_features *chip_features,
+			   const sensors_subfeature *subfeature,
+			   double *value)
+{
+	long long start;
+	int res;
+
+	/* Virtual chips aggregate other chips, which account for their own
+	   health */
+	if (chip_features->sources)
+		return sensors_eval_aggregate(chip_features, subfeature->number,
+					      NULL, NULL, value);
+
+	if ((res = sensors_chip_attr_begin(chip_features, &start)))
+		return res;
+	res = sensors_read_sysfs_attr(&chip_features->chip, subfeature, value);
+	sensors_chip_attr_end(chip_features, subfeature->number, res, start);
+	return res;
+}
+
+/* Read the value of a subfeature from sysfs, or from the cache if the
+   last value read is at most max_age milliseconds old. fresh is set if
+   the value wasn't served from the cache. */
+static int sensors_read_cached(const sensors_chip_features *chip_features,
+			       const sensors_subfeature *subfeature,
+			       int max_age, double *value, int *fresh)
+{
+	sensors_cache_entry *entry = &chip_features->cache[subfeature->number];
+	long long now;
+	int res;
+
+	/* A running publisher saves us the sysfs read, unless the caller
+	   explicitly asked for a fresh value */
+	if (max_age != 0) {
+		res = sensors_shm_read(chip_features, subfeature,
+				       max_age > 0 ? max_age : 0, value);
+		*fresh = !res;
+		if (res <= 0)
+			return res;
+	}
+
+	if (max_age == MAX_AGE_CHIP)
+		max_age = chip_features->cache_max_age;
+	else if (max_age == SENSORS_CACHE_UPDATE_INTERVAL)
+		max_age = chip_features->update_interval > 0 ?
+			  chip_features->update_interval : 0;
+
+	now = sensors_get_time_ms();
+	if (max_age > 0 && entry->stamp && now - entry->stamp <= max_age) {
+		*value = entry->value;
+		*fresh = 0;
+		return 0;
+	}
+
+	res = sensors_read_chip_attr(chip_features, subfeature, value);
+	*fresh = !res;
+	if (!res) {
+		entry->value = *value;
+		entry->stamp = now;
+	} else if (res == -SENSORS_ERR_SUSPENDED && entry->stamp) {
+		*value = entry->value;
+		res = -SENSORS_ERR_STALE;
+	}
+	return res;
+}
+
+/* Values read on behalf of another subfeature (nested) are not accounted
+   for in the rolling statistics, nor are the values served from the
+   cache: only the fresh values asked for by the application are */
+static int __sensors_compute_value(const sensors_chip_features *chip_features,
+				   const sensors_subfeature *subfeature,
+				   const sensors_eval_vars *vars, int max_age,
+				   int nested, double *result)
+{
+	const sensors_compute *compute = NULL;
+	double val;
+	int res, stale, fresh = 0;
+
+	if (!(subfeature->flags & SENSORS_MODE_R))
+		return -SENSORS_ERR_ACCESS_R;
+	if (chip_features->cyclic[subfeature->number])
+		return -SENSORS_ERR_RECURSION;
+
+	if (subfeature->flags & SENSORS_COMPUTE_MAPPING)
+		compute = chip_features->compute[subfeature->mapping];
+
+	/* A stale value is still worth computing */
+	stale = sensors_read_cached(chip_features, subfeature, max_age, &val,
+				    &fresh);
+	if (stale && stale != -SENSORS_ERR_STALE)
+		return stale;
+	if (!compute) {
+		*result = val;
+	} else {
+		res = sensors_eval_expr(chip_features, compute->from_proc, val,
+					vars, max_age, result);
+		if (SENSORS_PROBE_ENABLED(compute))
+			SENSORS_PROBE5(compute, chip_features->chip.path,
+				       subfeature->name, SENSORS_PROBE_MILLI(val),
+				       res ? 0 : SENSORS_PROBE_MILLI(*result),
+				       res);
+		if (res)
+			return res;
+	}
+	if (chip_features->rolling && fresh && !nested)
+		sensors_rolling_feed(chip_features, subfeature->number,
+				     *result);
+	return stale;
+}
+
+int sensors_compute_value(const sensors_chip_features *chip_features,
+			  const sensors_subfeature *subfeature,
+			  const sensors_eval_vars *vars, int max_age,
+			  double *result)
+{
+	int res;
+
+	sensors_lock_chip(chip_features);
+	res = __sensors_compute_value(chip_features, subfeature, vars, max_age,
+				      0, result);
+	sensors_unlock_chip(chip_features);
+	return res;
+}
+
+int sensors_compute_source(const sensors_chip_features *chip_features,
+			   const sensors_subfeature *subfeature, int max_age,
+			   double *result)
+{
+	int res;
+
+	sensors_lock_chip(chip_features);
+	res = __sensors_compute_value(chip_features, subfeature, NULL, max_age,
+				      1, result);
+	sensors_unlock_chip(chip_features);
+	return res;
+}
+
 /* Read the value of a subfeature of a certain chip. Note that chip should not
    contain wildcard values! This function will return 0 on success, and <0
    on failure. */
 static int __sensors_get_value(const sensors_chip_name *name, int subfeat_nr,
-			       int depth, double *result)
+			       int max_age, double *result)
 {
 	const sensors_chip_features *chip_features;
 	const sensors_subfeature *subfeature;
-	const sensors_expr *expr = NULL;
-	double val;
-	int res, i;
 
-	if (depth >= DEPTH_MAX)
-		return -SENSORS_ERR_RECURSION;
+	if (sensors_chip_name_has_wildcards(name))
+		return -SENSORS_ERR_WILDCARDS;
+	if (!(chip_features = sensors_lookup_chip(name)))
+		return -SENSORS_ERR_NO_ENTRY;
+	if (!(subfeature = sensors_lookup_subfeature_nr(chip_features,
+							subfeat_nr)))
+		return -SENSORS_ERR_NO_ENTRY;
+
+	return sensors_compute_value(chip_features, subfeature, NULL, max_age,
+				     result);
+}
+
+int sensors_get_value(const sensors_chip_name *name, int subfeat_nr,
+		      double *result)
+{
+	return __sensors_get_value(name, subfeat_nr, MAX_AGE_CHIP, result);
+}
+
+int sensors_get_value_max_age(const sensors_chip_name *name, int subfeat_nr,
+			      int max_age, double *result)
+{
+	if (max_age < 0 && max_age != SENSORS_CACHE_UPDATE_INTERVAL)
+		return -SENSORS_ERR_NO_ENTRY;
+	return __sensors_get_value(name, subfeat_nr, max_age, result);
+}
+
+int sensors_get_value_raw(const sensors_chip_name *name, int subfeat_nr,
+			  long long *value, int *exponent)
+{
+	const sensors_chip_features *chip_features;
+	const sensors_subfeature *subfeature;
+	const sensors_raw_affine *raw;
+	long long start, val;
+	int res;
+
 	if (sensors_chip_name_has_wildcards(name))
 		return -SENSORS_ERR_WILDCARDS;
 	if (!(chip_features = sensors_lookup_chip(name)))
@@ -244,42 +545,77 @@ static int __sensors_get_value(const sensors_chip_name *name, int subfeat_nr,
 		return -SENSORS_ERR_NO_ENTRY;
 	if (!(subfeature->flags & SENSORS_MODE_R))
 		return -SENSORS_ERR_ACCESS_R;
-
-	/* Apply compute statement if it exists */
-	if (subfeature->flags & SENSORS_COMPUTE_MAPPING) {
-		const sensors_feature *feature;
-		const sensors_chip *chip;
-
-		feature = sensors_lookup_feature_nr(chip_features,
-					subfeature->mapping);
-
-		chip = NULL;
-		while (!expr &&
-		       (chip = sensors_for_all_config_chips(name, chip)))
-			for (i = 0; i < chip->computes_count; i++) {
-				if (!strcmp(feature->name,
-					    chip->computes[i].name)) {
-					expr = chip->computes[i].from_proc;
-					break;
-				}
-			}
+	raw = &chip_features->raw[subfeat_nr];
+	if (!raw->exact)
+		return -SENSORS_ERR_INEXACT;
+
+	sensors_lock_chip(chip_features);
+	if (!(res = sensors_chip_attr_begin(chip_features, &start))) {
+		res = sensors_read_sysfs_attr_raw(&chip_features->chip,
+						  subfeature, &val);
+		sensors_chip_attr_end(chip_features, subfeat_nr, res, start);
 	}
-
-	res = sensors_read_sysfs_attr(name, subfeature, &val);
+	sensors_unlock_chip(chip_features);
 	if (res)
 		return res;
-	if (!expr)
-		*result = val;
-	else if ((res = sensors_eval_expr(chip_features, expr, val, depth,
-					  result)))
-		return res;
+
+	if (__builtin_mul_overflow(val, raw->mul, &val) ||
+	    __builtin_add_overflow(val, raw->add, &val))
+		return -SENSORS_ERR_INEXACT;
+	*value = val;
+	*exponent = raw->exponent;
 	return 0;
 }
 
-int sensors_get_value(const sensors_chip_name *name, int subfeat_nr,
-		      double *result)
+int sensors_set_cache_max_age(const sensors_chip_name *match, int max_age)
 {
-	return __sensors_get_value(name, subfeat_nr, 0, result);
+	sensors_chip_features *chip_features;
+	int i, found = 0;
+
+	if (max_age < 0 && max_age != SENSORS_CACHE_UPDATE_INTERVAL)
+		return -SENSORS_ERR_NO_ENTRY;
+
+	for (i = 0; i < sensors_proc_chips_count; i++) {
+		chip_features = &sensors_proc_chips[i];
+		if (match && !sensors_match_chip(&chip_features->chip, match))
+			continue;
+
+		sensors_lock_chip(chip_features);
+		if (max_age == SENSORS_CACHE_UPDATE_INTERVAL)
+			chip_features->cache_max_age =
+				chip_features->update_interval > 0 ?
+				chip_features->update_interval : 0;
+		else
+			chip_features->cache_max_age = max_age;
+		sensors_unlock_chip(chip_features);
+		found = 1;
+	}
+
+	return found ? 0 : -SENSORS_ERR_NO_ENTRY;
+}
+
+int sensors_get_chip_health(const sensors_chip_name *name,
+			    sensors_chip_health *health)
+{
+	const sensors_chip_features *chip_features;
+	const sensors_chip_state *state;
+	long long now;
+
+	if (sensors_chip_name_has_wildcards(name))
+		return -SENSORS_ERR_WILDCARDS;
+	if (!(chip_features = sensors_lookup_chip(name)))
+		return -SENSORS_ERR_NO_ENTRY;
+	state = chip_features->state;
+
+	now = sensors_get_time_ms();
+	sensors_lock_chip(chip_features);
+	health->quarantined = state->backoff != 0;
+	health->failures = state->failures;
+	health->latency = state->latency;
+	health->retry_in = state->backoff && state->retry > now ?
+			   state->retry - now : 0;
+	sensors_unlock_chip(chip_features);
+	return 0;
 }
 
 /* Set the value of a subfeature of a certain chip. Note that chip should not
@@ -290,8 +626,8 @@ int sensors_set_value(const sensors_chip_name *name, int subfeat_nr,
 {
 	const sensors_chip_features *chip_features;
 	const sensors_subfeature *subfeature;
-	const sensors_expr *expr = NULL;
-	int i, res;
+	const sensors_compute *compute = NULL;
+	int res;
 	double to_write;
 
 	if (sensors_chip_name_has_wildcards(name))
@@ -305,31 +641,23 @@ int sensors_set_value(const sensors_chip_name *name, int subfeat_nr,
 		return -SENSORS_ERR_ACCESS_W;
 
 	/* Apply compute statement if it exists */
-	if (subfeature->flags & SENSORS_COMPUTE_MAPPING) {
-		const sensors_feature *feature;
-		const sensors_chip *chip;
-
-		feature = sensors_lookup_feature_nr(chip_features,
-					subfeature->mapping);
-
-		chip = NULL;
-		while (!expr &&
-		       (chip = sensors_for_all_config_chips(name, chip)))
-			for (i = 0; i < chip->computes_count; i++) {
-				if (!strcmp(feature->name,
-					    chip->computes[i].name)) {
-					expr = chip->computes[i].to_proc;
-					break;
-				}
-			}
-	}
+	if (subfeature->flags & SENSORS_COMPUTE_MAPPING)
+		compute = chip_features->compute[subfeature->mapping];
 
+	sensors_lock_chip(chip_features);
 	to_write = value;
-	if (expr)
-		if ((res = sensors_eval_expr(chip_features, expr,
-					     value, 0, &to_write)))
-			return res;
-	return sensors_write_sysfs_attr(name, subfeature, to_write);
+	if (compute)
+		res = sensors_eval_expr(chip_features, compute->to_proc,
+					value, NULL, MAX_AGE_CHIP, &to_write);
+	else
+		res = 0;
+	if (!res) {
+		/* Whatever we had in the cache is now outdated */
+		chip_features->cache[subfeature->number].stamp = 0;
+		res = sensors_write_sysfs_attr(name, subfeature, to_write);
+	}
+	sensors_unlock_chip(chip_features);
+	return res;
 }
 
 const sensors_chip_name *sensors_get_detected_chips(const sensors_chip_name
@@ -389,14 +717,31 @@ sensors_get_features(const sensors_chip_name *name, int *nr)
 	if (!(chip = sensors_lookup_chip(name)))
 		return NULL;	/* No such chip */
 
-	while (*nr < chip->feature_count
-	    && sensors_get_ignored(name, &chip->feature[*nr]))
+	while (*nr < chip->feature_count && chip->ignored[*nr])
 		(*nr)++;
 	if (*nr >= chip->feature_count)
 		return NULL;
 	return &chip->feature[(*nr)++];
 }
 
+int sensors_get_chip_layout(const sensors_chip_name *name,
+			    sensors_chip_layout *layout)
+{
+	const sensors_chip_features *chip;
+
+	if (sensors_chip_name_has_wildcards(name))
+		return -SENSORS_ERR_WILDCARDS;
+	if (!(chip = sensors_lookup_chip(name)))
+		return -SENSORS_ERR_NO_ENTRY;
+
+	layout->features = chip->feature;
+	layout->feature_count = chip->feature_count;
+	layout->subfeatures = chip->subfeature;
+	layout->subfeature_count = chip->subfeature_count;
+	layout->ignored = chip->ignored;
+	return 0;
+}
+
 const sensors_subfeature *
 sensors_get_all_subfeatures(const sensors_chip_name *name,
 			const sensors_feature *feature, int *nr)
@@ -438,10 +783,36 @@ sensors_get_subfeature(const sensors_chip_name *name,
 	return NULL;	/* No such subfeature */
 }
 
-/* Evaluate an expression */
+/* Interpolate linearly between the two points of a table around x.
+   Values beyond the first and last points are clamped. */
+double sensors_eval_table(const sensors_table *table, double x)
+{
+	const sensors_point *p = table->points;
+	int lo = 0, hi = table->count - 1, mid;
+
+	if (x <= p[lo].x)
+		return p[lo].y;
+	if (x >= p[hi].x)
+		return p[hi].y;
+
+	/* p[lo].x < x < p[hi].x */
+	while (hi - lo > 1) {
+		mid = (lo + hi) / 2;
+		if (x < p[mid].x)
+			hi = mid;
+		else
+			lo = mid;
+	}
+	return p[lo].y + (p[hi].y - p[lo].y) * (x - p[lo].x) /
+			 (p[hi].x - p[lo].x);
+}
+
+/* Evaluate an expression. Variables are taken from vars if set, and read
+   otherwise. */
 static int sensors_eval_expr(const sensors_chip_features *chip_features,
-			     const sensors_expr *expr,
-			     double val, int depth, double *result)
+			     const sensors_expr *expr, double val,
+			     const sensors_eval_vars *vars, int max_age,
+			     double *result)
 {
 	double res1, res2;
 	int res;
@@ -455,20 +826,29 @@ static int sensors_eval_expr(const sensors_chip_features *chip_features,
 		*result = val;
 		return 0;
 	}
+	if (expr->kind == sensors_kind_table) {
+		*result = sensors_eval_table(&expr->data.table, val);
+		return 0;
+	}
 	if (expr->kind == sensors_kind_var) {
 		if (!(subfeature = sensors_lookup_subfeature_name(chip_features,
 							    expr->data.var)))
 			return -SENSORS_ERR_NO_ENTRY;
-		return __sensors_get_value(&chip_features->chip,
-					   subfeature->number, depth + 1,
-					   result);
+		if (vars) {
+			res = vars->error[subfeature->number];
+			*result = vars->value[subfeature->number];
+		} else
+			res = sensors_compute_source(chip_features, subfeature,
+						     max_age, result);
+		/* Don't let a stale value pass for a fresh one */
+		return res == -SENSORS_ERR_STALE ? -SENSORS_ERR_SUSPENDED : res;
 	}
 	if ((res = sensors_eval_expr(chip_features, expr->data.subexpr.sub1,
-				     val, depth, &res1)))
+				     val, vars, max_age, &res1)))
 		return res;
 	if (expr->data.subexpr.sub2 &&
 	    (res = sensors_eval_expr(chip_features, expr->data.subexpr.sub2,
-				     val, depth, &res2)))
+				     val, vars, max_age, &res2)))
 		return res;
 	switch (expr->data.subexpr.op) {
 	case sensors_add:
@@ -528,7 +908,7 @@ static int sensors_do_this_chip_sets(const sensors_chip_name *name)
 
 			res = sensors_eval_expr(chip_features,
 						chip->sets[i].value, 0,
-						0, &value);
+						NULL, MAX_AGE_CHIP, &value);
 			if (res) {
 				sensors_parse_error_wfn("Error parsing expression",
 						    chip->sets[i].line.filename,
@@ -563,3 +943,307 @@ int sensors_do_chip_sets(const sensors_chip_name *name)
 	}
 	return res;
 }
+
+/* Look up the compute statement which applies to a feature, if any */
+static const sensors_compute *
+sensors_lookup_compute(const sensors_chip_name *name,
+		       const sensors_feature *feature)
+{
+	const sensors_chip *chip;
+	int i;
+
+	for (chip = NULL; (chip = sensors_for_all_config_chips(name, chip));)
+		for (i = 0; i < chip->computes_count; i++)
+			if (!strcmp(feature->name, chip->computes[i].name))
+				return &chip->computes[i];
+	return NULL;
+}
+
+#define EVAL_VISITING	1
+#define EVAL_DONE	2
+
+static int sensors_order_subfeature(sensors_chip_features *chip_features,
+				    int subfeat_nr, char *state);
+
+/* Order all subfeatures an expression refers to. Returns 1 if one of them
+   is part of, or depends on, a cycle. */
+static int sensors_order_expr(sensors_chip_features *chip_features,
+			      const sensors_expr *expr, char *state)
+{
+	const sensors_subfeature *subfeature;
+	int cyclic = 0;
+
+	switch (expr->kind) {
+	case sensors_kind_var:
+		subfeature = sensors_lookup_subfeature_name(chip_features,
+							    expr->data.var);
+		if (subfeature)
+			cyclic = sensors_order_subfeature(chip_features,
+							  subfeature->number,
+							  state);
+		break;
+	case sensors_kind_sub:
+		cyclic = sensors_order_expr(chip_features,
+					    expr->data.subexpr.sub1, state);
+		if (expr->data.subexpr.sub2)
+			cyclic |= sensors_order_expr(chip_features,
+						     expr->data.subexpr.sub2,
+						     state);
+		break;
+	default:
+		break;
+	}
+	return cyclic;
+}
+
+/* Depth-first walk of the dependencies of a subfeature, appending it to the
+   evaluation order after them. Returns 1 if the subfeature is part of, or
+   depends on, a cycle. */
+static int sensors_order_subfeature(sensors_chip_features *chip_features,
+				    int subfeat_nr, char *state)
+{
+	const sensors_subfeature *subfeature;
+	const sensors_compute *compute;
+
+	if (state[subfeat_nr] == EVAL_VISITING)
+		return 1;
+	if (state[subfeat_nr] == EVAL_DONE)
+		return chip_features->cyclic[subfeat_nr];
+	state[subfeat_nr] = EVAL_VISITING;
+
+	subfeature = &chip_features->subfeature[subfeat_nr];
+	if (subfeature->flags & SENSORS_COMPUTE_MAPPING) {
+		compute = chip_features->compute[subfeature->mapping];
+		if (compute)
+			chip_features->cyclic[subfeat_nr] =
+				sensors_order_expr(chip_features,
+						   compute->from_proc, state);
+	}
+
+	state[subfeat_nr] = EVAL_DONE;
+	if (!chip_features->cyclic[subfeat_nr])
+		chip_features->eval_order[chip_features->eval_count++] =
+			subfeat_nr;
+	return chip_features->cyclic[subfeat_nr];
+}
+
+/* Integer forms of compute statements: at most this many decimal digits
+   are added to the exponent, and coefficients stay below RAW_INT_MAX */
+#define RAW_DIGITS_MAX		6
+#define RAW_INT_MAX		1e15
+
+/* Reduce an expression to a * source + b, if it has that form */
+static int sensors_expr_affine(const sensors_expr *expr, double *a, double *b)
+{
+	double a1, b1, a2 = 0, b2 = 0;
+
+	switch (expr->kind) {
+	case sensors_kind_val:
+		*a = 0;
+		*b = expr->data.val;
+		return 1;
+	case sensors_kind_source:
+		*a = 1;
+		*b = 0;
+		return 1;
+	case sensors_kind_var:
+	case sensors_kind_table:
+		return 0;
+	case sensors_kind_sub:
+		break;
+	}
+
+	if (!sensors_expr_affine(expr->data.subexpr.sub1, &a1, &b1))
+		return 0;
+	if (expr->data.subexpr.sub2 &&
+	    !sensors_expr_affine(expr->data.subexpr.sub2, &a2, &b2))
+		return 0;
+	switch (expr->data.subexpr.op) {
+	case sensors_add:
+		*a = a1 + a2;
+		*b = b1 + b2;
+		return 1;
+	case sensors_sub:
+		*a = a1 - a2;
+		*b = b1 - b2;
+		return 1;
+	case sensors_multiply:
+		if (a1 != 0 && a2 != 0)
+			return 0;
+		*a = a1 * b2 + a2 * b1;
+		*b = b1 * b2;
+		return 1;
+	case sensors_divide:
+		if (a2 != 0 || b2 == 0)
+			return 0;
+		*a = a1 / b2;
+		*b = b1 / b2;
+		return 1;
+	case sensors_negate:
+		*a = -a1;
+		*b = -b1;
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/* Check whether x is an integer, save for the rounding of decimal
+   constants */
+static int sensors_is_integer(double x, long long *n)
+{
+	if (fabs(x) >= RAW_INT_MAX || fabs(x - rint(x)) > 1e-9 * fabs(x))
+		return 0;
+	*n = llrint(x);
+	return 1;
+}
+
+/* Find the integer form of the compute statement of a subfeature. Decimal
+   coefficients are made integers by lowering the exponent. */
+static void sensors_bind_raw(const sensors_chip_features *chip_features,
+			     const sensors_subfeature *subfeature,
+			     sensors_raw_affine *raw)
+{
+	const sensors_compute *compute = NULL;
+	double a, b;
+	int k;
+
+	raw->mul = 1;
+	raw->add = 0;
+	raw->exponent = sensors_get_type_exponent(subfeature->type);
+	raw->exact = !chip_features->sources;	/* Not read from sysfs */
+
+	if (subfeature->flags & SENSORS_COMPUTE_MAPPING)
+		compute = chip_features->compute[subfeature->mapping];
+	if (!compute)
+		return;
+
+	raw->exact = 0;
+	if (!sensors_expr_affine(compute->from_proc, &a, &b))
+		return;
+	for (k = 0; k <= RAW_DIGITS_MAX; k++) {
+		if (sensors_is_integer(a * pow(10, k), &raw->mul) &&
+		    sensors_is_integer(b * pow(10, k - raw->exponent),
+				       &raw->add)) {
+			raw->exponent -= k;
+			raw->exact = 1;
+			return;
+		}
+	}
+}
+
+/* Bind each feature of a chip to its compute statement, and sort the
+   subfeatures so that the variables of an expression are always evaluated
+   before the expression itself. */
+static void sensors_bind_chip_computes(sensors_chip_features *chip_features)
+{
+	const sensors_compute *compute;
+	char *state;
+	int i, j;
+
+	chip_features->compute = calloc(chip_features->feature_count,
+					sizeof(const sensors_compute *));
+	chip_features->eval_order = malloc(chip_features->subfeature_count *
+					   sizeof(int));
+	chip_features->cyclic = calloc(chip_features->subfeature_count, 1);
+	state = calloc(chip_features->subfeature_count, 1);
+	if (!chip_features->compute || !chip_features->eval_order ||
+	    !chip_features->cyclic || !state)
+		sensors_fatal_error(__func__, "Out of memory");
+
+	for (i = 0; i < chip_features->feature_count; i++)
+		chip_features->compute[i] = sensors_lookup_compute(
+						&chip_features->chip,
+						&chip_features->feature[i]);
+
+	chip_features->eval_count = 0;
+	for (i = 0; i < chip_features->subfeature_count; i++)
+		sensors_order_subfeature(chip_features, i, state);
+	free(state);
+
+	chip_features->raw = malloc(chip_features->subfeature_count *
+				    sizeof(sensors_raw_affine));
+	if (!chip_features->raw)
+		sensors_fatal_error(__func__, "Out of memory");
+	for (i = 0; i < chip_features->subfeature_count; i++)
+		sensors_bind_raw(chip_features, &chip_features->subfeature[i],
+				 &chip_features->raw[i]);
+
+	/* Report each compute statement involved in a cycle once */
+	for (i = 0; i < chip_features->feature_count; i++) {
+		compute = chip_features->compute[i];
+		if (!compute)
+			continue;
+		for (j = chip_features->feature[i].first_subfeature;
+		     j < chip_features->subfeature_count &&
+		     chip_features->subfeature[j].mapping == i; j++) {
+			if (chip_features->cyclic[j]) {
+				sensors_parse_error_wfn("Circular dependency in compute",
+							compute->line.filename,
+							compute->line.lineno);
+				break;
+			}
+		}
+	}
+}
+
+void sensors_bind_computes(void)
+{
+	int i;
+
+	for (i = 0; i < sensors_proc_chips_count; i++)
+		sensors_bind_chip_computes(&sensors_proc_chips[i]);
+}
+
+static const char *known_options[] = {
+	"no_wakeup",
+	"quarantine",
+	NULL
+};
+
+int sensors_option_is_known(const char *name)
+{
+	int i;
+
+	for (i = 0; known_options[i]; i++)
+		if (!strcmp(name, known_options[i]))
+			return 1;
+	return 0;
+}
+
+/* Check whether an option is set for a chip */
+static int sensors_get_option(const sensors_chip_name *name,
+			      const char *option)
+{
+	const sensors_chip *chip;
+	int i;
+
+	for (chip = NULL; (chip = sensors_for_all_config_chips(name, chip));)
+		for (i = 0; i < chip->options_count; i++)
+			if (!strcmp(option, chip->options[i].name))
+				return 1;
+	return 0;
+}
+
+void sensors_bind_options(void)
+{
+	sensors_chip_features *chip_features;
+	int i, j;
+
+	for (i = 0; i < sensors_proc_chips_count; i++) {
+		chip_features = &sensors_proc_chips[i];
+		chip_features->no_wakeup =
+			sensors_get_option(&chip_features->chip, "no_wakeup");
+		chip_features->quarantine =
+			sensors_get_option(&chip_features->chip, "quarantine");
+
+		chip_features->ignored = calloc(chip_features->feature_count
+						+ 1, 1);
+		if (!chip_features->ignored)
+			sensors_fatal_error(__func__, "Out of memory");
+		for (j = 0; j < chip_features->feature_count; j++)
+			chip_features->ignored[j] =
+				sensors_get_ignored(&chip_features->chip,
+						    &chip_features->feature[j]);
+	}
+}
@@ -25,9 +25,90 @@
 #include "sensors.h"
 #include "data.h"
 
+/* Special max_age value meaning that the cache setting of the chip
+   applies */
+#define MAX_AGE_CHIP	(-2)
+
+/* Known values of the subfeatures of a chip, indexed by subfeature number,
+   for evaluating expressions without reading their variables again */
+typedef struct sensors_eval_vars {
+	const double *value;
+	const int *error;	/* 0 if value is valid */
+} sensors_eval_vars;
+
+/* Compare two chips name descriptions, to see whether they could match.
+   Return 0 if it does not match, return 1 if it does match. */
+int sensors_match_chip(const sensors_chip_name *chip1,
+		       const sensors_chip_name *chip2);
+
+/* Allocate and free the read state of a chip */
+sensors_chip_state *sensors_new_chip_state(void);
+void sensors_free_chip_state(sensors_chip_state *state);
+
+/* The cache, health, rolling statistics and read statistics of a chip are
+   only accessed with the chip locked, as the sampler and snapshot threads
+   read chips too. The lock is recursive, as compute statements read other
+   subfeatures of the same chip. A virtual chip is locked before the chips
+   it aggregates, never after. */
+void sensors_lock_chip(const sensors_chip_features *chip);
+void sensors_unlock_chip(const sensors_chip_features *chip);
+
+/* Look up a chip in the intern chip list, and return a pointer to it.
+   Returns NULL if not found. */
+const sensors_chip_features *
+sensors_lookup_chip(const sensors_chip_name *name);
+
+/* Look up a subfeature of a chip by name. Returns NULL if not found. */
+const sensors_subfeature *
+sensors_lookup_subfeature_name(const sensors_chip_features *chip,
+			       const char *name);
+
 /* Check whether the chip name is an 'absolute' name, which can only match
    one chip, or whether it has wildcards. Returns 0 if it is absolute, 1
    if there are wildcards. */
 int sensors_chip_name_has_wildcards(const sensors_chip_name *chip);
 
+/* Check whether a subfeature is an alarm flag. Returns 1 if it is, 0
+   if not. */
+int sensors_subfeature_is_alarm(const sensors_subfeature *subfeature);
+
+/* Read the value of a subfeature from sysfs, keeping track of failures.
+   Returns -SENSORS_ERR_QUARANTINE without reading if the chip has option
+   quarantine and was too slow lately. The chip must be locked. */
+int sensors_read_chip_attr(const sensors_chip_features *chip_features,
+			   const sensors_subfeature *subfeature,
+			   double *value);
+
+/* Read the value of a subfeature and apply its compute statement, if any.
+   Variables of the expression are taken from vars if set, and read
+   otherwise. The chip is locked meanwhile. Returns 0 on success, <0 on
+   error. */
+int sensors_compute_value(const sensors_chip_features *chip_features,
+			  const sensors_subfeature *subfeature,
+			  const sensors_eval_vars *vars, int max_age,
+			  double *result);
+
+/* Same as sensors_compute_value(), for a value read on behalf of another
+   subfeature, as a variable or a source: it is not accounted for in the
+   rolling statistics. */
+int sensors_compute_source(const sensors_chip_features *chip_features,
+			   const sensors_subfeature *subfeature, int max_age,
+			   double *result);
+
+/* Evaluate a table statement at raw value x */
+double sensors_eval_table(const sensors_table *table, double x);
+
+/* Check whether an option statement names an option we know of. Returns
+   1 if it does, 0 if not. */
+int sensors_option_is_known(const char *name);
+
+/* Apply the option and ignore statements of the configuration to the
+   detected chips */
+void sensors_bind_options(void);
+
+/* Bind the compute statements of the configuration to the detected chips,
+   and work out the order in which subfeatures must be evaluated. Cycles
+   between compute statements are reported as parse errors. */
+void sensors_bind_computes(void);
+
 #endif /* def LIB_SENSORS_ACCESS_H */
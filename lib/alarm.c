@@ -0,0 +1,125 @@
+/*
+    alarm.c - Part of libsensors, a Linux library for reading sensor data.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "access.h"
+#include "general.h"
+#include "alarm.h"
+
+#define BITS_PER_LONG	(8 * sizeof(unsigned long))
+
+/* The alarm subfeatures of all detected chips, in chip order. Bit i of an
+   alarm bitmap stands for alarm i. */
+typedef struct sensors_alarm {
+	const sensors_chip_features *chip;
+	const sensors_subfeature *subfeature;
+} sensors_alarm;
+
+static sensors_alarm *alarms;
+static int alarms_count = -1;	/* -1 until the table is built */
+static int alarms_max;
+
+#define alarms_add(el) sensors_add_array_el( \
+	(el), &alarms, &alarms_count, &alarms_max, sizeof(sensors_alarm))
+
+static void sensors_build_alarms(void)
+{
+	const sensors_chip_features *chip;
+	sensors_alarm alarm;
+	int i, j;
+
+	alarms_count = 0;
+	for (i = 0; i < sensors_proc_chips_count; i++) {
+		chip = &sensors_proc_chips[i];
+		for (j = 0; j < chip->subfeature_count; j++) {
+			if (!(chip->subfeature[j].flags & SENSORS_MODE_R) ||
+			    !sensors_subfeature_is_alarm(&chip->subfeature[j]))
+				continue;
+			alarm.chip = chip;
+			alarm.subfeature = &chip->subfeature[j];
+			alarms_add(&alarm);
+		}
+	}
+}
+
+int sensors_get_alarm_count(void)
+{
+	if (alarms_count < 0)
+		sensors_build_alarms();
+	return alarms_count;
+}
+
+int sensors_read_alarms(unsigned long *bitmap)
+{
+	double value;
+	int i, active = 0;
+
+	if (alarms_count < 0)
+		sensors_build_alarms();
+
+	memset(bitmap, 0, SENSORS_ALARM_LONGS(alarms_count) *
+	       sizeof(unsigned long));
+	/* Alarms which can't be read are reported as inactive */
+	for (i = 0; i < alarms_count; i++) {
+		if (sensors_compute_value(alarms[i].chip, alarms[i].subfeature,
+					  NULL, MAX_AGE_CHIP, &value) ||
+		    value == 0)
+			continue;
+		bitmap[i / BITS_PER_LONG] |= 1UL << (i % BITS_PER_LONG);
+		active++;
+	}
+
+	return active;
+}
+
+const sensors_subfeature *
+sensors_get_next_alarm(const unsigned long *bitmap, int *nr,
+		       const sensors_chip_name **name,
+		       const sensors_feature **feature)
+{
+	const sensors_alarm *alarm;
+
+	if (alarms_count < 0)
+		return NULL;
+
+	for (; *nr < alarms_count; (*nr)++) {
+		if (!(bitmap[*nr / BITS_PER_LONG] &
+		      (1UL << (*nr % BITS_PER_LONG))))
+			continue;
+		alarm = &alarms[(*nr)++];
+		*name = &alarm->chip->chip;
+		if (feature)
+			*feature = alarm->chip->feature +
+				   alarm->subfeature->mapping;
+		return alarm->subfeature;
+	}
+	return NULL;
+}
+
+void sensors_cleanup_alarms(void)
+{
+	free(alarms);
+	alarms = NULL;
+	alarms_count = -1;
+	alarms_max = 0;
+}
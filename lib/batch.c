@@ -0,0 +1,314 @@
+/*
+    batch.c - Part of libsensors, a Linux library for reading sensor data.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+
+/* Batch evaluation of compute statements, for reprocessing many raw values
+   at once. Variables are substituted first. The expression is then
+   reduced to a polynomial of the raw value if possible, which is
+   evaluated with vector operations. Other expressions are evaluated one
+   operation at a time over blocks of values, so the expression tree is
+   walked once per block rather than once per value. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "access.h"
+#include "general.h"
+#include "probes.h"
+
+#define POLY_DEGREE_MAX	4
+#define VEC_SIZE	4
+#define BATCH_BLOCK	256	/* values per block */
+
+SENSORS_PROBE_DEFINE(compute_array);
+
+typedef double vec_t __attribute__((vector_size(VEC_SIZE * sizeof(double))));
+
+/* Copy an expression, with the variables replaced by their current values.
+   Tables are shared with the original expression. */
+static int batch_bind(const sensors_chip_features *chip_features,
+		      const sensors_expr *expr, sensors_expr **bound)
+{
+	const sensors_subfeature *subfeature;
+	sensors_expr *copy;
+	int res;
+
+	copy = malloc(sizeof(sensors_expr));
+	if (!copy)
+		sensors_fatal_error(__func__, "Out of memory");
+	*copy = *expr;
+	*bound = copy;
+
+	switch (expr->kind) {
+	case sensors_kind_var:
+		copy->kind = sensors_kind_val;
+		if (!(subfeature = sensors_lookup_subfeature_name(chip_features,
+							expr->data.var)))
+			return -SENSORS_ERR_NO_ENTRY;
+		res = sensors_compute_source(chip_features, subfeature,
+					     MAX_AGE_CHIP, &copy->data.val);
+		/* Don't let a stale value pass for a fresh one */
+		return res == -SENSORS_ERR_STALE ? -SENSORS_ERR_SUSPENDED : res;
+	case sensors_kind_sub:
+		copy->data.subexpr.sub1 = copy->data.subexpr.sub2 = NULL;
+		if ((res = batch_bind(chip_features, expr->data.subexpr.sub1,
+				      &copy->data.subexpr.sub1)))
+			return res;
+		if (expr->data.subexpr.sub2)
+			return batch_bind(chip_features,
+					  expr->data.subexpr.sub2,
+					  &copy->data.subexpr.sub2);
+		return 0;
+	default:
+		return 0;
+	}
+}
+
+static void batch_free(sensors_expr *expr)
+{
+	if (!expr)
+		return;
+	if (expr->kind == sensors_kind_sub) {
+		batch_free(expr->data.subexpr.sub1);
+		batch_free(expr->data.subexpr.sub2);
+	}
+	free(expr);
+}
+
+/* Reduce an expression to a polynomial of the raw value, with coefficients
+   c[0] to c[degree]. Returns the degree, or -1 if the expression isn't a
+   polynomial of degree POLY_DEGREE_MAX at most. The operations are
+   reordered, (@-32)/1.8 becomes @/1.8 - 32/1.8 for example, so the result
+   may differ in the last bits. */
+static int batch_poly(const sensors_expr *expr, double *c)
+{
+	double c1[POLY_DEGREE_MAX + 1], c2[POLY_DEGREE_MAX + 1];
+	int d1, d2 = 0, i, j;
+
+	switch (expr->kind) {
+	case sensors_kind_val:
+		c[0] = expr->data.val;
+		return 0;
+	case sensors_kind_source:
+		c[0] = 0;
+		c[1] = 1;
+		return 1;
+	case sensors_kind_sub:
+		break;
+	default:
+		return -1;
+	}
+
+	if ((d1 = batch_poly(expr->data.subexpr.sub1, c1)) < 0)
+		return -1;
+	if (expr->data.subexpr.sub2 &&
+	    (d2 = batch_poly(expr->data.subexpr.sub2, c2)) < 0)
+		return -1;
+	for (i = d1 + 1; i <= POLY_DEGREE_MAX; i++)
+		c1[i] = 0;
+	for (i = d2 + 1; i <= POLY_DEGREE_MAX; i++)
+		c2[i] = 0;
+
+	switch (expr->data.subexpr.op) {
+	case sensors_add:
+		for (i = 0; i <= POLY_DEGREE_MAX; i++)
+			c[i] = c1[i] + c2[i];
+		return d1 > d2 ? d1 : d2;
+	case sensors_sub:
+		for (i = 0; i <= POLY_DEGREE_MAX; i++)
+			c[i] = c1[i] - c2[i];
+		return d1 > d2 ? d1 : d2;
+	case sensors_multiply:
+		if (d1 + d2 > POLY_DEGREE_MAX)
+			return -1;
+		for (i = 0; i <= POLY_DEGREE_MAX; i++)
+			c[i] = 0;
+		for (i = 0; i <= d1; i++)
+			for (j = 0; j <= d2; j++)
+				c[i + j] += c1[i] * c2[j];
+		return d1 + d2;
+	case sensors_divide:
+		if (d2 > 0 || c2[0] == 0.0)
+			return -1;
+		for (i = 0; i <= d1; i++)
+			c[i] = c1[i] / c2[0];
+		return d1;
+	case sensors_negate:
+		for (i = 0; i <= d1; i++)
+			c[i] = -c1[i];
+		return d1;
+	default:
+		return -1;
+	}
+}
+
+/* Horner's method, VEC_SIZE values at a time */
+static void batch_eval_poly(const double *c, int degree, const double *raw,
+			    double *value, int count)
+{
+	vec_t x, y;
+	double sx, sy;
+	int i, k;
+
+	for (i = 0; i + VEC_SIZE <= count; i += VEC_SIZE) {
+		memcpy(&x, raw + i, sizeof(x));
+		y = (vec_t){ 0 } + c[degree];
+		for (k = degree - 1; k >= 0; k--)
+			y = y * x + c[k];
+		memcpy(value + i, &y, sizeof(y));
+	}
+	for (; i < count; i++) {
+		sx = raw[i];
+		sy = c[degree];
+		for (k = degree - 1; k >= 0; k--)
+			sy = sy * sx + c[k];
+		value[i] = sy;
+	}
+}
+
+/* Evaluate an expression over n raw values, n being BATCH_BLOCK at most.
+   Values which can't be computed are set to NaN. Returns 1 if there are
+   any, 0 otherwise. */
+static int batch_eval_block(const sensors_expr *expr, const double *raw,
+			    double *out, int n)
+{
+	double tmp[BATCH_BLOCK];
+	const sensors_subexpr *sub;
+	int i, err;
+
+	switch (expr->kind) {
+	case sensors_kind_val:
+		for (i = 0; i < n; i++)
+			out[i] = expr->data.val;
+		return 0;
+	case sensors_kind_source:
+		memcpy(out, raw, n * sizeof(double));
+		return 0;
+	case sensors_kind_table:
+		for (i = 0; i < n; i++)
+			out[i] = sensors_eval_table(&expr->data.table, raw[i]);
+		return 0;
+	case sensors_kind_sub:
+		break;
+	default:	/* Variables were bound already */
+		for (i = 0; i < n; i++)
+			out[i] = NAN;
+		return 1;
+	}
+
+	sub = &expr->data.subexpr;
+	err = batch_eval_block(sub->sub1, raw, out, n);
+	if (sub->sub2)
+		err |= batch_eval_block(sub->sub2, raw, tmp, n);
+
+	switch (sub->op) {
+	case sensors_add:
+		for (i = 0; i < n; i++)
+			out[i] += tmp[i];
+		break;
+	case sensors_sub:
+		for (i = 0; i < n; i++)
+			out[i] -= tmp[i];
+		break;
+	case sensors_multiply:
+		for (i = 0; i < n; i++)
+			out[i] *= tmp[i];
+		break;
+	case sensors_divide:
+		for (i = 0; i < n; i++) {
+			if (tmp[i] == 0.0) {
+				out[i] = NAN;
+				err = 1;
+			} else
+				out[i] /= tmp[i];
+		}
+		break;
+	case sensors_negate:
+		for (i = 0; i < n; i++)
+			out[i] = -out[i];
+		break;
+	case sensors_exp:
+		for (i = 0; i < n; i++)
+			out[i] = exp(out[i]);
+		break;
+	case sensors_log:
+		for (i = 0; i < n; i++) {
+			if (out[i] < 0.0) {
+				out[i] = NAN;
+				err = 1;
+			} else
+				out[i] = log(out[i]);
+		}
+		break;
+	}
+	return err;
+}
+
+int sensors_compute_array(const sensors_chip_name *name, int subfeat_nr,
+			  const double *raw, double *value, int count)
+{
+	const sensors_chip_features *chip_features;
+	const sensors_subfeature *subfeature;
+	const sensors_compute *compute = NULL;
+	double c[POLY_DEGREE_MAX + 1], block[BATCH_BLOCK];
+	sensors_expr *expr;
+	int i, n, degree, res, err = 0;
+
+	if (sensors_chip_name_has_wildcards(name))
+		return -SENSORS_ERR_WILDCARDS;
+	if (!(chip_features = sensors_lookup_chip(name)) ||
+	    subfeat_nr < 0 || subfeat_nr >= chip_features->subfeature_count ||
+	    count < 0)
+		return -SENSORS_ERR_NO_ENTRY;
+	subfeature = &chip_features->subfeature[subfeat_nr];
+	if (chip_features->cyclic[subfeat_nr])
+		return -SENSORS_ERR_RECURSION;
+
+	if (subfeature->flags & SENSORS_COMPUTE_MAPPING)
+		compute = chip_features->compute[subfeature->mapping];
+	if (!compute) {
+		memmove(value, raw, count * sizeof(double));
+		return 0;
+	}
+
+	if ((res = batch_bind(chip_features, compute->from_proc, &expr))) {
+		batch_free(expr);
+		return res;
+	}
+
+	if ((degree = batch_poly(expr, c)) >= 0) {
+		batch_eval_poly(c, degree, raw, value, count);
+	} else {
+		/* Through a buffer, in case raw and value are the same */
+		for (i = 0; i < count; i += n) {
+			n = count - i < BATCH_BLOCK ? count - i : BATCH_BLOCK;
+			err |= batch_eval_block(expr, raw + i, block, n);
+			memcpy(value + i, block, n * sizeof(double));
+		}
+	}
+	batch_free(expr);
+
+	res = err ? -SENSORS_ERR_DIV_ZERO : 0;
+	SENSORS_PROBE4(compute_array, chip_features->chip.path,
+		       subfeature->name, count, res);
+	return res;
+}
@@ -0,0 +1,105 @@
+#  Module.mk - Makefile for the libsensors benchmarks
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; version 2 of the License.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+#  MA 02110-1301 USA.
+
+# The benchmarks are only built by "make bench". They link the static
+# objects of the library, so they run without installing it. Results are
+# printed as JSON, one benchmark per line, and saved to bench-*.json.
+
+LIB_DIR		:= lib
+LIB_BENCH_DIR	:= lib/bench
+
+LIB_BENCH_TARGETS := $(LIB_BENCH_DIR)/bench-lib $(LIB_BENCH_DIR)/bench-conf
+LIB_BENCH_SOURCES := $(LIB_BENCH_DIR)/bench.c $(LIB_BENCH_DIR)/bench-lib.c \
+		     $(LIB_BENCH_DIR)/bench-conf.c
+
+# Generated trees, <chips>x<channels>
+LIB_BENCH_TREES := $(patsubst %,$(LIB_BENCH_DIR)/trees/%,4x4 16x8 64x16)
+# The configuration files parsed by bench-conf, quoted as some names
+# have parentheses
+LIB_BENCH_CONFIGS := $(patsubst %,'%',$(sort $(shell find configs -type f)) \
+                                      etc/sensors.conf.eg)
+# Minimum run time of each benchmark, in milliseconds
+BENCH_TIME := 500
+
+$(LIB_BENCH_DIR)/bench-lib: $(LIB_BENCH_DIR)/bench.ro \
+			   $(LIB_BENCH_DIR)/bench-lib.ro $(LIBSTOBJECTS)
+	$(CC) $(EXLDFLAGS) -o $@ $^ -lm -lrt -lpthread
+
+$(LIB_BENCH_DIR)/bench-conf: $(LIB_BENCH_DIR)/bench.ro \
+			    $(LIB_BENCH_DIR)/bench-conf.ro $(LIBSTOBJECTS)
+	$(CC) $(EXLDFLAGS) -o $@ $^ -lm -lrt -lpthread
+
+$(LIB_BENCH_DIR)/trees/%:
+	$(RM) -r $@
+	prog/debug/gen-hwmon-tree -c $(word 1,$(subst x, ,$*)) \
+		-n $(word 2,$(subst x, ,$*)) $@
+
+$(LIB_BENCH_SOURCES:.c=.ro): $(LIB_BENCH_DIR)/bench.h $(LIB_DIR)/sensors.h
+$(LIB_BENCH_DIR)/bench-conf.ro: $(LIB_DIR)/data.h $(LIB_DIR)/conf.h \
+				$(LIB_DIR)/conf-parse.h $(LIB_DIR)/scanner.h
+
+bench-lib: $(LIB_BENCH_DIR)/bench-lib $(LIB_BENCH_TREES)
+	$(LIB_BENCH_DIR)/bench-lib -t $(BENCH_TIME) $(LIB_BENCH_TREES) \
+		> $(LIB_BENCH_DIR)/bench-lib.json; \
+	status=$$?; cat $(LIB_BENCH_DIR)/bench-lib.json; exit $$status
+bench :: bench-lib
+
+# Fails if parsing gets superlinear in the size of the input
+bench-conf: $(LIB_BENCH_DIR)/bench-conf
+	$(LIB_BENCH_DIR)/bench-conf -t $(BENCH_TIME) -s $(LIB_BENCH_CONFIGS) \
+		> $(LIB_BENCH_DIR)/bench-conf.json; \
+	status=$$?; cat $(LIB_BENCH_DIR)/bench-conf.json; exit $$status
+bench :: bench-conf
+
+# Shorter runs are enough to train the profile of "make pgo"
+PGO_BENCH_TIME := 100
+# Where bench-pgo keeps the results of each build, cleaned by bench-pgo only
+BENCH_RESULTS_DIR := bench-results
+
+# Run the programs on the trees, to train their profile too
+pgo-train-progs: $(LIB_BENCH_TREES)
+	for tree in $(LIB_BENCH_TREES); do \
+		SENSORS_SYSFS_ROOT=$$tree LD_LIBRARY_PATH=$(LIB_DIR) \
+			prog/sensors/sensors -c etc/sensors.conf.default \
+			> /dev/null || exit; \
+		SENSORS_SYSFS_ROOT=$$tree LD_LIBRARY_PATH=$(LIB_DIR) \
+			prog/latency/sensors-latency -c etc/sensors.conf.default \
+			-n 100 -i 0 -j > /dev/null || exit; \
+	done
+
+# Compare the benchmarks of the default build and of "make pgo". This
+# rebuilds everything, three times.
+bench-pgo:
+	$(RM) -r $(BENCH_RESULTS_DIR)
+	$(MKDIR) $(BENCH_RESULTS_DIR)/default $(BENCH_RESULTS_DIR)/pgo
+	$(MAKE) clean
+	$(MAKE) bench
+	cp $(LIB_BENCH_DIR)/bench-*.json $(BENCH_RESULTS_DIR)/default
+	$(MAKE) pgo
+	$(MAKE) LTO=1 PGO=use bench
+	cp $(LIB_BENCH_DIR)/bench-*.json $(BENCH_RESULTS_DIR)/pgo
+	cat $(BENCH_RESULTS_DIR)/default/bench-*.json \
+		> $(BENCH_RESULTS_DIR)/default.json
+	cat $(BENCH_RESULTS_DIR)/pgo/bench-*.json \
+		> $(BENCH_RESULTS_DIR)/pgo.json
+	$(LIB_BENCH_DIR)/bench-compare $(BENCH_RESULTS_DIR)/default.json \
+		$(BENCH_RESULTS_DIR)/pgo.json | tee $(BENCH_RESULTS_DIR)/report.txt
+
+clean-lib-bench:
+	$(RM) $(LIB_BENCH_DIR)/*.rd $(LIB_BENCH_DIR)/*.ro
+	$(RM) $(LIB_BENCH_TARGETS) $(LIB_BENCH_DIR)/bench-*.json
+	$(RM) -r $(LIB_BENCH_DIR)/trees
+clean :: clean-lib-bench
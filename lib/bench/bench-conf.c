@@ -0,0 +1,339 @@
+/*
+    bench-conf.c - Part of lm_sensors, Linux kernel modules for hardware
+                   monitoring. Throughput of the configuration file parser.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; version 2 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+/* The configuration files given on the command line are scanned, and
+   parsed by sensors_init() with an empty tree in place of /sys, so that
+   only the parser, the bus substitution and the cleanup are measured.
+   Files which can't be parsed are skipped, as they would only measure
+   error recovery. The others are parsed one by one, then concatenated 1,
+   4 and 16 times. With -s, the program fails if the time per byte of the
+   largest input is more than SUPERLINEAR_RATIO times that of the
+   smallest. */
+
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "lib/sensors.h"
+#include "lib/error.h"
+#include "lib/data.h"
+#include "lib/conf.h"
+#include "lib/conf-parse.h"
+#include "lib/scanner.h"
+#include "bench.h"
+
+#define SUPERLINEAR_RATIO	2.0
+
+struct input {
+	const char *name;
+	char *buf;
+	size_t len;
+	long tokens;
+	long statements;
+};
+
+/* What one operation goes through */
+struct corpus {
+	struct input *inputs;
+	int count;
+};
+
+static const int concat_times[] = { 1, 4, 16 };
+
+static void usage(void)
+{
+	fprintf(stderr, "Usage: bench-conf [-t <milliseconds>] [-s] "
+		"<config file>...\n");
+}
+
+static void read_input(struct input *input, const char *name)
+{
+	FILE *f;
+	long len;
+
+	if (!(f = fopen(name, "r")) || fseek(f, 0, SEEK_END) ||
+	    (len = ftell(f)) < 0 || fseek(f, 0, SEEK_SET)) {
+		perror(name);
+		exit(1);
+	}
+	input->name = name;
+	input->len = len;
+	if (!(input->buf = malloc(len + 1)) ||
+	    fread(input->buf, 1, len, f) != (size_t)len) {
+		perror(name);
+		exit(1);
+	}
+	input->buf[len] = '\0';
+	fclose(f);
+}
+
+static FILE *open_input(const struct input *input)
+{
+	FILE *f;
+
+	if (!(f = fmemopen(input->buf, input->len, "r"))) {
+		perror("fmemopen");
+		exit(1);
+	}
+	return f;
+}
+
+/* Scan an input, return the number of tokens. A statement is a sequence
+   of tokens ended by EOL. */
+static long scan(const struct input *input, long *statements)
+{
+	FILE *f = open_input(input);
+	long tokens = 0;
+	int token, last = EOL;
+
+	if (sensors_scanner_init(f, NULL)) {
+		fprintf(stderr, "%s: Can't initialize the scanner\n",
+			input->name);
+		exit(1);
+	}
+	while ((token = sensors_yylex())) {
+		if (token == NAME)
+			free(sensors_yylval.name);
+		if (token == EOL && last != EOL && statements)
+			(*statements)++;
+		last = token;
+		tokens++;
+	}
+	sensors_scanner_exit();
+	fclose(f);
+	return tokens;
+}
+
+static int parse(const struct input *input)
+{
+	FILE *f = open_input(input);
+	int err;
+
+	if (!(err = sensors_init(f)))
+		sensors_cleanup();
+	fclose(f);
+	return err;
+}
+
+static void quiet_parse_error(const char *err, int lineno)
+{
+	(void)err; (void)lineno; /* hide warning */
+}
+
+static void quiet_parse_error_wfn(const char *err, const char *filename,
+				  int lineno)
+{
+	(void)err; (void)filename; (void)lineno; /* hide warning */
+}
+
+static void bench_scan(void *data)
+{
+	const struct corpus *corpus = data;
+	int i;
+
+	for (i = 0; i < corpus->count; i++)
+		scan(&corpus->inputs[i], NULL);
+}
+
+static void bench_parse(void *data)
+{
+	const struct corpus *corpus = data;
+	int i;
+
+	for (i = 0; i < corpus->count; i++)
+		parse(&corpus->inputs[i]);
+}
+
+/* Concatenate the inputs times times */
+static void concat(struct input *res, const struct corpus *corpus,
+		   int times)
+{
+	size_t off = 0;
+	int i, t;
+
+	memset(res, 0, sizeof(*res));
+	for (i = 0; i < corpus->count; i++) {
+		res->len += corpus->inputs[i].len + 1;
+		res->tokens += corpus->inputs[i].tokens;
+		res->statements += corpus->inputs[i].statements;
+	}
+	res->len *= times;
+	res->tokens *= times;
+	res->statements *= times;
+	if (!(res->buf = malloc(res->len + 1))) {
+		perror("malloc");
+		exit(1);
+	}
+	/* Files may not end with a newline */
+	for (t = 0; t < times; t++) {
+		for (i = 0; i < corpus->count; i++) {
+			memcpy(res->buf + off, corpus->inputs[i].buf,
+			       corpus->inputs[i].len);
+			off += corpus->inputs[i].len;
+			res->buf[off++] = '\n';
+		}
+	}
+	res->buf[off] = '\0';
+	res->name = "concatenation";
+}
+
+/* Run a benchmark, report it with rates, return the time per byte */
+static double run(const char *name, bench_fn fn, struct corpus *corpus,
+		  int times)
+{
+	struct bench_result res;
+	char params[256];
+	size_t len = 0;
+	long tokens = 0, statements = 0;
+	int i;
+
+	for (i = 0; i < corpus->count; i++) {
+		len += corpus->inputs[i].len;
+		tokens += corpus->inputs[i].tokens;
+		statements += corpus->inputs[i].statements;
+	}
+	bench_measure(fn, corpus, &res);
+	snprintf(params, sizeof(params),
+		 "\"files\":%d,\"times\":%d,\"bytes\":%zu,\"tokens\":%ld,"
+		 "\"statements\":%ld,\"tokens_per_s\":%.0f,"
+		 "\"statements_per_s\":%.0f", corpus->count, times, len,
+		 tokens, statements, tokens * 1e9 / res.ns,
+		 statements * 1e9 / res.ns);
+	bench_report(name, params, &res);
+
+	return res.ns / len;
+}
+
+/* An empty directory in place of /sys */
+static char *make_empty_tree(void)
+{
+	static char tree[] = "/tmp/bench-conf.XXXXXX";
+	char path[64];
+
+	if (!mkdtemp(tree)) {
+		perror("mkdtemp");
+		exit(1);
+	}
+	snprintf(path, sizeof(path), "%s/class", tree);
+	mkdir(path, 0755);
+	snprintf(path, sizeof(path), "%s/class/hwmon", tree);
+	mkdir(path, 0755);
+	if (sensors_set_sysfs_root(tree)) {
+		fprintf(stderr, "%s: Invalid tree\n", tree);
+		exit(1);
+	}
+	return tree;
+}
+
+static void remove_empty_tree(const char *tree)
+{
+	char path[64];
+
+	snprintf(path, sizeof(path), "%s/class/hwmon", tree);
+	rmdir(path);
+	snprintf(path, sizeof(path), "%s/class", tree);
+	rmdir(path);
+	rmdir(tree);
+}
+
+int main(int argc, char *argv[])
+{
+	struct corpus corpus, concatenated;
+	struct input input;
+	double first = 0, last = 0, per_byte;
+	int c, i, check = 0;
+	char *tree;
+
+	while ((c = getopt(argc, argv, "t:sh")) != -1) {
+		switch (c) {
+		case 't':
+			bench_time = atoi(optarg);
+			break;
+		case 's':
+			check = 1;
+			break;
+		case 'h':
+			usage();
+			exit(0);
+		default:
+			usage();
+			exit(1);
+		}
+	}
+	if (optind == argc || bench_time <= 0) {
+		usage();
+		exit(1);
+	}
+
+	if (bench_init())
+		fprintf(stderr, "Warning: Can't count system calls\n");
+	tree = make_empty_tree();
+
+	corpus.count = argc - optind;
+	if (!(corpus.inputs = calloc(corpus.count, sizeof(struct input)))) {
+		perror("calloc");
+		exit(1);
+	}
+	sensors_parse_error = quiet_parse_error;
+	sensors_parse_error_wfn = quiet_parse_error_wfn;
+	for (i = 0; optind < argc; optind++) {
+		read_input(&corpus.inputs[i], argv[optind]);
+		if (parse(&corpus.inputs[i])) {
+			fprintf(stderr, "Warning: Skipping %s, which can't be "
+				"parsed\n", argv[optind]);
+			free(corpus.inputs[i].buf);
+			continue;
+		}
+		corpus.inputs[i].tokens = scan(&corpus.inputs[i],
+					       &corpus.inputs[i].statements);
+		i++;
+	}
+	corpus.count = i;
+
+	run("scan_files", bench_scan, &corpus, 1);
+	run("parse_files", bench_parse, &corpus, 1);
+
+	concatenated.inputs = &input;
+	concatenated.count = 1;
+	for (i = 0; i < (int)(sizeof(concat_times) / sizeof(concat_times[0]));
+	     i++) {
+		concat(&input, &corpus, concat_times[i]);
+		run("scan_concat", bench_scan, &concatenated, concat_times[i]);
+		per_byte = run("parse_concat", bench_parse, &concatenated,
+			       concat_times[i]);
+		if (!i)
+			first = per_byte;
+		last = per_byte;
+		free(input.buf);
+	}
+
+	for (i = 0; i < corpus.count; i++)
+		free(corpus.inputs[i].buf);
+	free(corpus.inputs);
+	remove_empty_tree(tree);
+
+	if (check && last > first * SUPERLINEAR_RATIO) {
+		fprintf(stderr, "Parsing is superlinear: %.1f ns/byte for %d "
+			"times the input, %.1f ns/byte for one time\n", last,
+			concat_times[i - 1], first);
+		return 1;
+	}
+	return 0;
+}
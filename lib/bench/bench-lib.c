@@ -0,0 +1,286 @@
+/*
+    bench-lib.c - Part of lm_sensors, Linux kernel modules for hardware
+                  monitoring. Microbenchmarks of the libsensors API.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; version 2 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+/* Each tree given on the command line is read in place of /sys, once
+   without any configuration and once with a generated configuration
+   which labels, computes and sets every voltage and temperature. The
+   difference between init_config and init_discovery is the cost of
+   parsing and binding the configuration. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "lib/sensors.h"
+#include "lib/error.h"
+#include "bench.h"
+
+struct input {
+	const sensors_chip_name *chip;
+	int nr;
+};
+
+struct label {
+	const sensors_chip_name *chip;
+	const sensors_feature *feature;
+};
+
+static FILE *empty, *config;
+static struct input *inputs;
+static int inputs_count;
+static struct label *labels;
+static int labels_count;
+static int next;
+static char params[256];
+
+static void usage(void)
+{
+	fprintf(stderr, "Usage: bench-lib [-t <milliseconds>] <tree>...\n");
+}
+
+static void init(FILE *input)
+{
+	int err;
+
+	rewind(input);
+	if ((err = sensors_init(input))) {
+		fprintf(stderr, "sensors_init: %s\n", sensors_strerror(err));
+		exit(1);
+	}
+}
+
+/* List the inputs and features of the chips which were just detected */
+static void list_chip_inputs(void)
+{
+	const sensors_chip_name *chip;
+	const sensors_feature *feature;
+	const sensors_subfeature *sf;
+	int c = 0, f, s;
+
+	inputs_count = labels_count = 0;
+	while ((chip = sensors_get_detected_chips(NULL, &c))) {
+		f = 0;
+		while ((feature = sensors_get_features(chip, &f))) {
+			labels = realloc(labels, (labels_count + 1) *
+					 sizeof(*labels));
+			if (!labels) {
+				perror("realloc");
+				exit(1);
+			}
+			labels[labels_count].chip = chip;
+			labels[labels_count++].feature = feature;
+
+			s = 0;
+			while ((sf = sensors_get_all_subfeatures(chip, feature,
+								 &s))) {
+				if ((sf->type & 0xff) || !(sf->flags & SENSORS_MODE_R))
+					continue;
+				inputs = realloc(inputs, (inputs_count + 1) *
+						 sizeof(*inputs));
+				if (!inputs) {
+					perror("realloc");
+					exit(1);
+				}
+				inputs[inputs_count].chip = chip;
+				inputs[inputs_count++].nr = sf->number;
+			}
+		}
+	}
+	next = 0;
+}
+
+/* Label, compute and set every voltage and temperature */
+static FILE *generate_config(void)
+{
+	const sensors_chip_name *chip;
+	const sensors_feature *feature;
+	char name[256];
+	FILE *f;
+	int c = 0, i;
+
+	if (!(f = tmpfile())) {
+		perror("tmpfile");
+		exit(1);
+	}
+	while ((chip = sensors_get_detected_chips(NULL, &c))) {
+		if (sensors_snprintf_chip_name(name, sizeof(name), chip) < 0)
+			continue;
+		/* Chips on I2C buses need their bus declared */
+		if (chip->bus.type == SENSORS_BUS_TYPE_I2C)
+			fprintf(f, "bus \"i2c-%d\" \"%s\"\n", chip->bus.nr,
+				sensors_get_adapter_name(&chip->bus));
+		fprintf(f, "chip \"%s\"\n", name);
+		i = 0;
+		while ((feature = sensors_get_features(chip, &i))) {
+			switch (feature->type) {
+			case SENSORS_FEATURE_IN:
+				fprintf(f, "    label %s \"Rail %d\"\n"
+					"    compute %s @*2, @/2\n",
+					feature->name, feature->number,
+					feature->name);
+				break;
+			case SENSORS_FEATURE_TEMP:
+				fprintf(f, "    label %s \"Zone %d\"\n"
+					"    compute %s @+1, @-1\n",
+					feature->name, feature->number,
+					feature->name);
+				if (sensors_get_subfeature(chip, feature,
+						SENSORS_SUBFEATURE_TEMP_MAX))
+					fprintf(f, "    set %s_max 80\n",
+						feature->name);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+	return f;
+}
+
+static void bench_init_discovery(void *data)
+{
+	(void)data; /* hide warning */
+	init(empty);
+	sensors_cleanup();
+}
+
+static void bench_init_config(void *data)
+{
+	(void)data; /* hide warning */
+	init(config);
+	sensors_cleanup();
+}
+
+static void bench_get_value(void *data)
+{
+	const struct input *input = &inputs[next++ % inputs_count];
+	double value;
+	(void)data; /* hide warning */
+
+	sensors_get_value(input->chip, input->nr, &value);
+}
+
+static void bench_enumerate(void *data)
+{
+	const sensors_chip_name *chip;
+	const sensors_feature *feature;
+	int c = 0, f, s;
+	(void)data; /* hide warning */
+
+	while ((chip = sensors_get_detected_chips(NULL, &c))) {
+		f = 0;
+		while ((feature = sensors_get_features(chip, &f))) {
+			s = 0;
+			while (sensors_get_all_subfeatures(chip, feature, &s))
+				;
+		}
+	}
+}
+
+static void bench_get_label(void *data)
+{
+	const struct label *label = &labels[next++ % labels_count];
+	(void)data; /* hide warning */
+
+	free(sensors_get_label(label->chip, label->feature));
+}
+
+static void bench_do_chip_sets(void *data)
+{
+	(void)data; /* hide warning */
+	sensors_do_chip_sets(NULL);
+}
+
+static void bench_tree(const char *tree)
+{
+	const char *base;
+	int chips = 0;
+
+	if (sensors_set_sysfs_root(tree)) {
+		fprintf(stderr, "%s: Invalid tree\n", tree);
+		exit(1);
+	}
+	base = strrchr(tree, '/') ? strrchr(tree, '/') + 1 : tree;
+
+	init(empty);
+	while (sensors_get_detected_chips(NULL, &chips))
+		;
+	list_chip_inputs();
+	config = generate_config();
+	snprintf(params, sizeof(params),
+		 "\"tree\":\"%s\",\"chips\":%d,\"inputs\":%d", base, chips,
+		 inputs_count);
+
+	if (inputs_count)
+		bench_run("get_value", params, bench_get_value, NULL);
+	bench_run("enumerate", params, bench_enumerate, NULL);
+	sensors_cleanup();
+
+	bench_run("init_discovery", params, bench_init_discovery, NULL);
+	bench_run("init_config", params, bench_init_config, NULL);
+
+	init(config);
+	list_chip_inputs();
+	if (inputs_count)
+		bench_run("get_value_compute", params, bench_get_value, NULL);
+	if (labels_count)
+		bench_run("get_label", params, bench_get_label, NULL);
+	bench_run("do_chip_sets", params, bench_do_chip_sets, NULL);
+	sensors_cleanup();
+
+	fclose(config);
+}
+
+int main(int argc, char *argv[])
+{
+	int c;
+
+	while ((c = getopt(argc, argv, "t:h")) != -1) {
+		switch (c) {
+		case 't':
+			bench_time = atoi(optarg);
+			break;
+		case 'h':
+			usage();
+			exit(0);
+		default:
+			usage();
+			exit(1);
+		}
+	}
+	if (optind == argc || bench_time <= 0) {
+		usage();
+		exit(1);
+	}
+
+	if (bench_init())
+		fprintf(stderr, "Warning: Can't count system calls\n");
+	if (!(empty = tmpfile())) {
+		perror("tmpfile");
+		exit(1);
+	}
+
+	for (; optind < argc; optind++)
+		bench_tree(argv[optind]);
+
+	fclose(empty);
+	free(inputs);
+	free(labels);
+	return 0;
+}
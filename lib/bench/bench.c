@@ -0,0 +1,221 @@
+/*
+    bench.c - Part of lm_sensors, Linux kernel modules for hardware
+              monitoring. Benchmark harness.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; version 2 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+/* Allocations are counted by replacing malloc() and friends with
+   wrappers around the glibc allocator, so allocations made by the C
+   library on behalf of libsensors (fopen(), opendir()...) count too,
+   and so does the memory they use.
+   System calls are counted with the raw_syscalls:sys_enter tracepoint,
+   which needs tracefs and the permission to use it. */
+
+#include <linux/perf_event.h>
+#include <malloc.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "bench.h"
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static long long allocs;
+static long long bytes, peak_bytes;
+static int syscall_fd = -1;
+
+int bench_time = 500;
+
+/* Account for a block allocated (size > 0) or freed (size < 0) */
+static void *account(void *ptr, long long size)
+{
+	long long now, peak;
+
+	if (!ptr)
+		return NULL;
+	now = __atomic_add_fetch(&bytes, size, __ATOMIC_RELAXED);
+	peak = __atomic_load_n(&peak_bytes, __ATOMIC_RELAXED);
+	while (now > peak &&
+	       !__atomic_compare_exchange_n(&peak_bytes, &peak, now, 1,
+					    __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+	return ptr;
+}
+
+void *malloc(size_t size)
+{
+	void *ptr = __libc_malloc(size);
+
+	__atomic_fetch_add(&allocs, 1, __ATOMIC_RELAXED);
+	return account(ptr, malloc_usable_size(ptr));
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	void *ptr = __libc_calloc(nmemb, size);
+
+	__atomic_fetch_add(&allocs, 1, __ATOMIC_RELAXED);
+	return account(ptr, malloc_usable_size(ptr));
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	size_t old = malloc_usable_size(ptr);
+
+	__atomic_fetch_add(&allocs, 1, __ATOMIC_RELAXED);
+	ptr = __libc_realloc(ptr, size);
+	if (ptr)
+		account(ptr, (long long)malloc_usable_size(ptr) - old);
+	return ptr;
+}
+
+void free(void *ptr)
+{
+	account(ptr, -(long long)malloc_usable_size(ptr));
+	__libc_free(ptr);
+}
+
+long long bench_allocs(void)
+{
+	return __atomic_load_n(&allocs, __ATOMIC_RELAXED);
+}
+
+long long bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static const char *tracefs[] = {
+	"/sys/kernel/tracing",
+	"/sys/kernel/debug/tracing",
+};
+
+int bench_init(void)
+{
+	struct perf_event_attr attr;
+	char path[256];
+	FILE *f;
+	int i, id = -1;
+
+	for (i = 0; id < 0 && i < (int)(sizeof(tracefs) / sizeof(tracefs[0]));
+	     i++) {
+		snprintf(path, sizeof(path),
+			 "%s/events/raw_syscalls/sys_enter/id", tracefs[i]);
+		if (!(f = fopen(path, "r")))
+			continue;
+		if (fscanf(f, "%d", &id) != 1)
+			id = -1;
+		fclose(f);
+	}
+	if (id < 0)
+		return -1;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_TRACEPOINT;
+	attr.size = sizeof(attr);
+	attr.config = id;
+	attr.sample_period = 1;
+	attr.disabled = 1;
+	attr.inherit = 1;	/* count the threads of snapshots too */
+	syscall_fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+	return syscall_fd < 0 ? -1 : 0;
+}
+
+static long long bench_syscalls(void)
+{
+	uint64_t count;
+
+	if (syscall_fd < 0 || read(syscall_fd, &count, sizeof(count)) !=
+			      sizeof(count))
+		return -1;
+	return count;
+}
+
+/* Run n operations, return the time taken */
+static long long bench_loop(long long n, bench_fn fn, void *data)
+{
+	long long i, start;
+
+	start = bench_now();
+	for (i = 0; i < n; i++)
+		fn(data);
+	return bench_now() - start;
+}
+
+void bench_measure(bench_fn fn, void *data, struct bench_result *res)
+{
+	long long n, ns, target = bench_time * 1000000LL;
+	long long syscalls_start, syscalls, allocs_start, bytes_start;
+
+	/* Warm up, and find how many operations fill the time */
+	fn(data);
+	for (n = 1; (ns = bench_loop(n, fn, data)) < target / 10; n *= 10)
+		;
+	n = n * (target / (double)ns) + 1;
+
+	if (syscall_fd >= 0)
+		ioctl(syscall_fd, PERF_EVENT_IOC_ENABLE, 0);
+	syscalls_start = bench_syscalls();
+	allocs_start = bench_allocs();
+	bytes_start = __atomic_load_n(&bytes, __ATOMIC_RELAXED);
+	__atomic_store_n(&peak_bytes, bytes_start, __ATOMIC_RELAXED);
+	ns = bench_loop(n, fn, data);
+	res->allocs = (double)(bench_allocs() - allocs_start) / n;
+	res->peak_bytes = __atomic_load_n(&peak_bytes, __ATOMIC_RELAXED) -
+			  bytes_start;
+	syscalls = bench_syscalls();
+	if (syscall_fd >= 0)
+		ioctl(syscall_fd, PERF_EVENT_IOC_DISABLE, 0);
+
+	res->iterations = n;
+	res->ns = (double)ns / n;
+	res->syscalls = syscalls_start >= 0 && syscalls >= 0 ?
+			(double)(syscalls - syscalls_start) / n : -1;
+}
+
+void bench_report(const char *name, const char *params,
+		  const struct bench_result *res)
+{
+	printf("{\"bench\":\"%s\",%s,\"iterations\":%lld,\"ns_per_op\":%.1f,",
+	       name, params, res->iterations, res->ns);
+	if (res->syscalls >= 0)
+		printf("\"syscalls_per_op\":%.2f,", res->syscalls);
+	else
+		printf("\"syscalls_per_op\":null,");
+	printf("\"allocs_per_op\":%.2f,\"peak_bytes\":%lld}\n", res->allocs,
+	       res->peak_bytes);
+	fflush(stdout);
+}
+
+void bench_run(const char *name, const char *params, bench_fn fn,
+	       void *data)
+{
+	struct bench_result res;
+
+	bench_measure(fn, data, &res);
+	bench_report(name, params, &res);
+}
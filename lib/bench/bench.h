@@ -0,0 +1,61 @@
+/*
+    bench.h - Part of lm_sensors, Linux kernel modules for hardware
+              monitoring. Benchmark harness.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; version 2 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#ifndef LIB_BENCH_BENCH_H
+#define LIB_BENCH_BENCH_H
+
+/* One operation of a benchmark */
+typedef void (*bench_fn)(void *data);
+
+/* The cost of one operation */
+struct bench_result {
+	long long iterations;
+	double ns;
+	double syscalls;	/* <0 if they can't be counted */
+	double allocs;
+	long long peak_bytes;	/* most memory allocated at once */
+};
+
+/* Minimum run time of each benchmark, in milliseconds */
+extern int bench_time;
+
+/* Set up the counters. Returns 0 on success, <0 if syscalls can't be
+   counted, in which case they are reported as null. */
+int bench_init(void);
+
+/* Run fn repeatedly for at least bench_time milliseconds, and measure
+   the cost of one operation */
+void bench_measure(bench_fn fn, void *data, struct bench_result *res);
+
+/* Print a result as a JSON object on one line. params is a list of JSON
+   members describing the benchmark, without braces. */
+void bench_report(const char *name, const char *params,
+		  const struct bench_result *res);
+
+/* Measure and report */
+void bench_run(const char *name, const char *params, bench_fn fn,
+	       void *data);
+
+/* Number of allocations made so far */
+long long bench_allocs(void);
+
+/* Time elapsed since some fixed point, in nanoseconds */
+long long bench_now(void);
+
+#endif /* def LIB_BENCH_BENCH_H */
@@ -34,8 +34,12 @@
 
 static void sensors_yyerror(const char *err);
 static sensors_expr *malloc_expr(void);
+static int aggregate_function(const char *name);
+static const char *check_table(const sensors_table *table);
+static sensors_expr *inverse_table(const sensors_table *table);
 
 static sensors_chip *current_chip = NULL;
+static sensors_virtual *current_virtual = NULL;
 
 #define bus_add_el(el) sensors_add_array_el(el,\
                                       &sensors_config_busses,\
@@ -62,12 +66,33 @@ static sensors_chip *current_chip = NULL;
                                           &current_chip->ignores_count,\
                                           &current_chip->ignores_max,\
                                           sizeof(sensors_ignore));
+#define option_add_el(el) sensors_add_array_el(el,\
+                                          &current_chip->options,\
+                                          &current_chip->options_count,\
+                                          &current_chip->options_max,\
+                                          sizeof(sensors_option));
+#define aggregate_add_el(el) sensors_add_array_el(el,\
+                                          &current_virtual->aggregates,\
+                                          &current_virtual->aggregates_count,\
+                                          &current_virtual->aggregates_max,\
+                                          sizeof(sensors_aggregate));
+#define virtual_add_el(el) sensors_add_array_el(el,\
+                                          &sensors_config_virtuals,\
+                                          &sensors_config_virtuals_count,\
+                                          &sensors_config_virtuals_max,\
+                                          sizeof(sensors_virtual));
 #define chip_add_el(el) sensors_add_array_el(el,\
                                        &sensors_config_chips,\
                                        &sensors_config_chips_count,\
                                        &sensors_config_chips_max,\
                                        sizeof(sensors_chip));
 
+#define point_add_el(el,table) sensors_add_array_el(el,\
+                                                   &(table).points,\
+                                                   &(table).count,\
+                                                   &(table).max,\
+                                                   sizeof(sensors_point));
+
 #define fits_add_el(el,list) sensors_add_array_el(el,\
                                                   &(list).fits,\
                                                   &(list).fits_count,\
@@ -85,6 +110,8 @@ static sensors_chip *current_chip = NULL;
   sensors_bus_id bus;
   sensors_chip_name chip;
   sensors_config_line line;
+  sensors_table table;
+  sensors_point point;
 }  
 
 %left <nothing> '-' '+'
@@ -99,7 +126,11 @@ static sensors_chip *current_chip = NULL;
 %token <line> SET
 %token <line> CHIP
 %token <line> COMPUTE
+%token <line> TABLE
 %token <line> IGNORE
+%token <line> OPTION
+%token <line> VIRTUAL
+%token <line> AGGREGATE
 %token <value> FLOAT
 %token <name> NAME
 %token <nothing> ERROR
@@ -111,6 +142,9 @@ static sensors_chip *current_chip = NULL;
 %type <name> function_name
 %type <name> string
 %type <chip> chip_name
+%type <table> point_list
+%type <point> point
+%type <value> number
 
 %start input
 
@@ -125,7 +159,11 @@ line:	  bus_statement EOL
 	| set_statement EOL
 	| chip_statement EOL
 	| compute_statement EOL
+	| table_statement EOL
 	| ignore_statement EOL
+	| option_statement EOL
+	| virtual_statement EOL
+	| aggregate_statement EOL
 	| error	EOL
 ;
 
@@ -185,6 +223,54 @@ compute_statement:	  COMPUTE function_name expression ',' expression
 			  }
 ;
 
+table_statement:	TABLE function_name point_list
+			{ sensors_compute new_el;
+			  const char *err;
+			  if (!current_chip) {
+			    sensors_yyerror("Table statement before first chip statement");
+			    free($2);
+			    free($3.points);
+			    YYERROR;
+			  }
+			  if ((err = check_table(&$3))) {
+			    sensors_yyerror(err);
+			    free($2);
+			    free($3.points);
+			    YYERROR;
+			  }
+			  new_el.line = $1;
+			  new_el.name = $2;
+			  new_el.from_proc = malloc_expr();
+			  new_el.from_proc->kind = sensors_kind_table;
+			  new_el.from_proc->data.table = $3;
+			  new_el.to_proc = inverse_table(&$3);
+			  compute_add_el(&new_el);
+			}
+;
+
+point_list:	  point
+		  { $$.points = NULL;
+		    $$.count = $$.max = 0;
+		    point_add_el(&$1,$$);
+		  }
+		| point_list ',' point
+		  { $$ = $1;
+		    point_add_el(&$3,$$);
+		  }
+;
+
+point:		  number number
+		  { $$.x = $1;
+		    $$.y = $2;
+		  }
+;
+
+number:		  FLOAT
+		  { $$ = $1; }
+		| '-' FLOAT
+		  { $$ = -$2; }
+;
+
 ignore_statement:	IGNORE function_name
 			{ sensors_ignore new_el;
 			  if (!current_chip) {
@@ -198,6 +284,69 @@ ignore_statement:	IGNORE function_name
 			}
 ;
 
+option_statement:	OPTION function_name
+			{ sensors_option new_el;
+			  if (!current_chip) {
+			    sensors_yyerror("Option statement before first chip statement");
+			    free($2);
+			    YYERROR;
+			  }
+			  if (!sensors_option_is_known($2)) {
+			    sensors_yyerror("Unknown option");
+			    free($2);
+			    YYERROR;
+			  }
+			  new_el.line = $1;
+			  new_el.name = $2;
+			  option_add_el(&new_el);
+			}
+;
+
+virtual_statement:	VIRTUAL string
+			{ sensors_virtual new_el;
+			  if (!*$2 || strpbrk($2, "-*")) {
+			    sensors_yyerror("Invalid virtual chip name");
+			    free($2);
+			    YYERROR;
+			  }
+			  new_el.line = $1;
+			  new_el.name = $2;
+			  new_el.aggregates = NULL;
+			  new_el.aggregates_count = new_el.aggregates_max = 0;
+			  virtual_add_el(&new_el);
+			  current_virtual = sensors_config_virtuals +
+			                    sensors_config_virtuals_count - 1;
+			  current_chip = NULL;
+			}
+;
+
+aggregate_statement:	AGGREGATE function_name function_name string chip_name_list
+			{ sensors_aggregate new_el;
+			  int function = aggregate_function($3);
+			  free($3);
+			  if (!current_virtual) {
+			    sensors_yyerror("Aggregate statement before first virtual statement");
+			    free($2);
+			    free($4);
+			    sensors_free_chip_name_list(&$5);
+			    YYERROR;
+			  }
+			  if (function < 0) {
+			    sensors_yyerror("Unknown aggregate function");
+			    free($2);
+			    free($4);
+			    sensors_free_chip_name_list(&$5);
+			    YYERROR;
+			  }
+			  new_el.line = $1;
+			  new_el.name = $2;
+			  new_el.function = function;
+			  new_el.pattern = $4;
+			  new_el.chips = $5;
+			  aggregate_add_el(&new_el);
+			}
+;
+
 chip_statement:	  CHIP chip_name_list
 		  { sensors_chip new_el;
 		    new_el.line = $1;
@@ -205,14 +354,17 @@ chip_statement:	  CHIP chip_name_list
 		    new_el.sets = NULL;
 		    new_el.computes = NULL;
 		    new_el.ignores = NULL;
+		    new_el.options = NULL;
 		    new_el.labels_count = new_el.labels_max = 0;
 		    new_el.sets_count = new_el.sets_max = 0;
 		    new_el.computes_count = new_el.computes_max = 0;
 		    new_el.ignores_count = new_el.ignores_max = 0;
+		    new_el.options_count = new_el.options_max = 0;
 		    new_el.chips = $2;
 		    chip_add_el(&new_el);
 		    current_chip = sensors_config_chips + 
 		                   sensors_config_chips_count - 1;
+		    current_virtual = NULL;
 		  }
 ;
 
@@ -345,3 +497,55 @@ sensors_expr *malloc_expr(void)
     sensors_fatal_error(__func__, "Allocating a new expression");
   return res;
 }
+
+int aggregate_function(const char *name)
+{
+  if (!strcmp(name, "max"))
+    return SENSORS_AGGREGATE_MAX;
+  if (!strcmp(name, "min"))
+    return SENSORS_AGGREGATE_MIN;
+  if (!strcmp(name, "sum"))
+    return SENSORS_AGGREGATE_SUM;
+  if (!strcmp(name, "avg"))
+    return SENSORS_AGGREGATE_AVG;
+  return -1;
+}
+
+/* Check that a table is a monotonic function, so it can be inverted.
+   Returns an error message, or NULL if the table is valid. */
+const char *check_table(const sensors_table *table)
+{
+  int i, dir;
+
+  if (table->count < 2)
+    return "Table needs at least two points";
+  dir = table->points[1].y > table->points[0].y ? 1 : -1;
+  for (i = 1; i < table->count; i++) {
+    if (table->points[i].x <= table->points[i - 1].x)
+      return "Table points must be sorted";
+    if ((table->points[i].y - table->points[i - 1].y) * dir <= 0)
+      return "Table values must be monotonic";
+  }
+  return NULL;
+}
+
+/* The inverse of a table swaps x and y, and keeps the points sorted */
+sensors_expr *inverse_table(const sensors_table *table)
+{
+  sensors_expr *expr = malloc_expr();
+  sensors_point *points;
+  int i, n = table->count;
+  int reverse = table->points[1].y < table->points[0].y;
+
+  points = malloc(n * sizeof(sensors_point));
+  if (!points)
+    sensors_fatal_error(__func__, "Allocating a table");
+  for (i = 0; i < n; i++) {
+    points[reverse ? n - 1 - i : i].x = table->points[i].y;
+    points[reverse ? n - 1 - i : i].y = table->points[i].x;
+  }
+  expr->kind = sensors_kind_table;
+  expr->data.table.points = points;
+  expr->data.table.count = expr->data.table.max = n;
+  return expr;
+}
@@ -42,6 +42,11 @@ int sensors_config_chips_count = 0;
 int sensors_config_chips_subst = 0;
 int sensors_config_chips_max = 0;
 
+sensors_virtual *sensors_config_virtuals = NULL;
+int sensors_config_virtuals_count = 0;
+int sensors_config_virtuals_subst = 0;
+int sensors_config_virtuals_max = 0;
+
 sensors_bus *sensors_config_busses = NULL;
 int sensors_config_busses_count = 0;
 int sensors_config_busses_max = 0;
@@ -255,33 +260,55 @@ static int sensors_substitute_chip(sensors_chip_name *name,
 	return 0;
 }
 
+static int sensors_substitute_list(sensors_chip_name_list *chips,
+				   const sensors_config_line *line)
+{
+	int err, j;
+	int res = 0;
+
+	for (j = 0; j < chips->fits_count; j++) {
+		/* We can only substitute if a specific bus number
+		   is given. */
+		if (chips->fits[j].bus.nr == SENSORS_BUS_NR_ANY)
+			continue;
+
+		err = sensors_substitute_chip(&chips->fits[j],
+					      line->filename, line->lineno);
+		if (err)
+			res = err;
+	}
+	return res;
+}
+
 /* Bus substitution is on a per-configuration file basis, so we keep
-   memory (in sensors_config_chips_subst) of which chip entries have been
-   already substituted. */
+   memory (in sensors_config_chips_subst and sensors_config_virtuals_subst)
+   of which chip entries have been already substituted. */
 int sensors_substitute_busses(void)
 {
-	int err, i, j, lineno;
-	sensors_chip_name_list *chips;
-	const char *filename;
+	sensors_aggregate *aggregate;
+	int err, i, j;
 	int res = 0;
 
 	for (i = sensors_config_chips_subst;
 	     i < sensors_config_chips_count; i++) {
-		filename = sensors_config_chips[i].line.filename;
-		lineno = sensors_config_chips[i].line.lineno;
-		chips = &sensors_config_chips[i].chips;
-		for (j = 0; j < chips->fits_count; j++) {
-			/* We can only substitute if a specific bus number
-			   is given. */
-			if (chips->fits[j].bus.nr == SENSORS_BUS_NR_ANY)
-				continue;
-
-			err = sensors_substitute_chip(&chips->fits[j],
-						      filename, lineno);
+		err = sensors_substitute_list(&sensors_config_chips[i].chips,
+					      &sensors_config_chips[i].line);
+		if (err)
+			res = err;
+	}
+	sensors_config_chips_subst = sensors_config_chips_count;
+
+	for (i = sensors_config_virtuals_subst;
+	     i < sensors_config_virtuals_count; i++) {
+		for (j = 0; j < sensors_config_virtuals[i].aggregates_count;
+		     j++) {
+			aggregate = &sensors_config_virtuals[i].aggregates[j];
+			err = sensors_substitute_list(&aggregate->chips,
+						      &aggregate->line);
 			if (err)
 				res = err;
 		}
 	}
-	sensors_config_chips_subst = sensors_config_chips_count;
+	sensors_config_virtuals_subst = sensors_config_virtuals_count;
 	return res;
 }
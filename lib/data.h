@@ -22,6 +22,7 @@
 #ifndef LIB_SENSORS_DATA_H
 #define LIB_SENSORS_DATA_H
 
+#include <pthread.h>
 #include "sensors.h"
 #include "general.h"
 
@@ -38,13 +39,26 @@ typedef enum sensors_operation {
 /* An expression can have several forms */
 typedef enum sensors_expr_kind {
 	sensors_kind_val, sensors_kind_source, sensors_kind_var,
-	sensors_kind_sub
+	sensors_kind_sub, sensors_kind_table
 } sensors_expr_kind;
 
 /* An expression. It is either a floating point value, a variable name,
-   an operation on subexpressions, or the special value 'sub' } */
+   an operation on subexpressions, a table applied to the special value
+   'sub', or the special value 'sub' } */
 struct sensors_expr;
 
+typedef struct sensors_point {
+	double x;
+	double y;
+} sensors_point;
+
+/* A piecewise linear function, through points sorted by x */
+typedef struct sensors_table {
+	sensors_point *points;
+	int count;
+	int max;
+} sensors_table;
+
 typedef struct sensors_subexpr {
 	sensors_operation op;
 	struct sensors_expr *sub1;
@@ -57,6 +71,7 @@ typedef struct sensors_expr {
 		double val;
 		char *var;
 		sensors_subexpr subexpr;
+		sensors_table table;
 	} data;
 } sensors_expr;
 
@@ -97,6 +112,12 @@ typedef struct sensors_ignore {
 	sensors_config_line line;
 } sensors_ignore;
 
+/* Config file option declaration: an option name */
+typedef struct sensors_option {
+	char *name;
+	sensors_config_line line;
+} sensors_option;
+
 /* A list of chip names, used to represent a config file chips declaration */
 typedef struct sensors_chip_name_list {
 	sensors_chip_name *fits;
@@ -104,6 +125,33 @@ typedef struct sensors_chip_name_list {
 	int fits_max;
 } sensors_chip_name_list;
 
+/* Functions of aggregate declarations */
+typedef enum sensors_aggregate_fn {
+	SENSORS_AGGREGATE_MAX,
+	SENSORS_AGGREGATE_MIN,
+	SENSORS_AGGREGATE_SUM,
+	SENSORS_AGGREGATE_AVG,
+} sensors_aggregate_fn;
+
+/* Config file aggregate declaration: a subfeature name, combined with a
+   function of the subfeatures matching a pattern, in a list of chips */
+typedef struct sensors_aggregate {
+	char *name;
+	sensors_aggregate_fn function;
+	char *pattern;
+	sensors_chip_name_list chips;
+	sensors_config_line line;
+} sensors_aggregate;
+
+/* A config file virtual chip block */
+typedef struct sensors_virtual {
+	char *name;
+	sensors_aggregate *aggregates;
+	int aggregates_count;
+	int aggregates_max;
+	sensors_config_line line;
+} sensors_virtual;
+
 /* A config file chip block */
 typedef struct sensors_chip {
 	sensors_chip_name_list chips;
@@ -119,6 +167,9 @@ typedef struct sensors_chip {
 	sensors_ignore *ignores;
 	int ignores_count;
 	int ignores_max;
+	sensors_option *options;
+	int options_count;
+	int options_max;
 	sensors_config_line line;
 } sensors_chip;
 
@@ -130,6 +181,58 @@ typedef struct sensors_bus {
 	sensors_config_line line;
 } sensors_bus;
 
+/* Last value read from a subfeature, with the time it was read at */
+typedef struct sensors_cache_entry {
+	double value;
+	long long stamp;	/* in milliseconds, 0 if never read */
+} sensors_cache_entry;
+
+/* Read health of a chip. A chip with option quarantine which is slow
+   repeatedly is quarantined: it is not read until retry, and then only
+   once to probe it. The lock
+   serializes the accesses to everything a read of the chip updates, see
+   sensors_lock_chip(). */
+typedef struct sensors_chip_state {
+	pthread_mutex_t lock;
+	int failures;		/* consecutive slow reads */
+	int latency;		/* average read time, in microseconds */
+	int backoff;		/* in milliseconds, 0 if not quarantined */
+	long long retry;	/* time of the next probe, in milliseconds */
+} sensors_chip_state;
+
+/* Rolling statistics of a subfeature, see rolling.c */
+#define ROLLING_QUANTILES	3
+typedef struct sensors_rolling_state {
+	long long stamp;	/* of the last value, 0 if none */
+	double mean;
+	double var;
+	double quantile[ROLLING_QUANTILES];
+	long long bucket_start;	/* of the current half window */
+	double min[2];		/* current and previous half windows */
+	double max[2];
+	int count[2];
+} sensors_rolling_state;
+
+/* Integer form of the compute statement of a subfeature: the value is
+   (raw * mul + add) * 10^exponent, with raw the integer read from sysfs.
+   Only exact if the compute statement is an affine transform with
+   decimal coefficients. */
+typedef struct sensors_raw_affine {
+	long long mul;
+	long long add;
+	int exponent;
+	int exact;
+} sensors_raw_affine;
+
+/* Subfeatures an aggregate is computed from. Chips are indexes in
+   sensors_proc_chips, which may move. */
+typedef struct sensors_aggregate_sources {
+	const sensors_aggregate *aggregate;
+	int *chip;
+	int *subfeature;
+	int count;
+} sensors_aggregate_sources;
+
 /* Internal data about all features and subfeatures of a chip */
 typedef struct sensors_chip_features {
 	struct sensors_chip_name chip;
@@ -137,6 +240,26 @@ typedef struct sensors_chip_features {
 	struct sensors_subfeature *subfeature;
 	int feature_count;
 	int subfeature_count;
+	int i2c_root;		/* root adapter of I2C chips behind muxes */
+	int update_interval;	/* in milliseconds, -1 if unknown */
+	int cache_max_age;	/* in milliseconds, 0 if caching is disabled */
+	sensors_cache_entry *cache;	/* one per subfeature */
+	sensors_chip_state *state;
+	char *pm_path;		/* runtime PM status of the device, or NULL */
+	int no_wakeup;		/* don't read the chip while suspended */
+	int quarantine;		/* stop reading the chip while it is slow */
+	char *ignored;		/* one per feature, set by sensors_bind_options() */
+	/* Set by sensors_bind_computes() once the configuration is loaded */
+	const sensors_compute **compute;	/* one per feature, or NULL */
+	int *eval_order;	/* subfeature numbers, dependencies first */
+	int eval_count;		/* cyclic subfeatures are not in eval_order */
+	char *cyclic;		/* one per subfeature */
+	sensors_raw_affine *raw;	/* one per subfeature */
+	int rolling_window;	/* in milliseconds */
+	sensors_rolling_state *rolling;	/* one per subfeature, or NULL */
+	sensors_stats *stats;	/* one per subfeature, or NULL */
+	/* Virtual chips only, one per subfeature, NULL for detected chips */
+	sensors_aggregate_sources *sources;
 } sensors_chip_features;
 
 extern char **sensors_config_files;
@@ -152,6 +275,11 @@ extern int sensors_config_chips_count;
 extern int sensors_config_chips_subst;
 extern int sensors_config_chips_max;
 
+extern sensors_virtual *sensors_config_virtuals;
+extern int sensors_config_virtuals_count;
+extern int sensors_config_virtuals_subst;
+extern int sensors_config_virtuals_max;
+
 extern sensors_bus *sensors_config_busses;
 extern int sensors_config_busses_count;
 extern int sensors_config_busses_max;
@@ -36,7 +36,11 @@ static const char *errorlist[] = {
 	/* SENSORS_ERR_PARSE     */ "General parse error",
 	/* SENSORS_ERR_ACCESS_W  */ "Can't write",
 	/* SENSORS_ERR_IO        */ "I/O error",
-	/* SENSORS_ERR_RECURSION */ "Evaluation recurses too deep",
+	/* SENSORS_ERR_RECURSION */ "Circular or too deep compute evaluation",
+	/* SENSORS_ERR_QUARANTINE */ "Chip not responding, retrying later",
+	/* SENSORS_ERR_STALE     */ "Device suspended, value is stale",
+	/* SENSORS_ERR_SUSPENDED */ "Device suspended",
+	/* SENSORS_ERR_INEXACT   */ "Value can't be represented as an integer",
 };
 
 const char *sensors_strerror(int errnum)
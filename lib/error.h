@@ -32,7 +32,11 @@
 #define SENSORS_ERR_PARSE	8 /* General parse error */
 #define SENSORS_ERR_ACCESS_W	9 /* Can't write */
 #define SENSORS_ERR_IO		10 /* I/O error */
-#define SENSORS_ERR_RECURSION	11 /* Evaluation recurses too deep */
+#define SENSORS_ERR_RECURSION	11 /* Circular or too deep compute evaluation */
+#define SENSORS_ERR_QUARANTINE	12 /* Chip failing, not read for a while */
+#define SENSORS_ERR_STALE	13 /* Device suspended, last known value */
+#define SENSORS_ERR_SUSPENDED	14 /* Device suspended, no known value */
+#define SENSORS_ERR_INEXACT	15 /* Value not representable as integer */
 
 #ifdef __cplusplus
 extern "C" {
@@ -34,6 +34,13 @@ void sensors_add_array_el(const void *el, void *list, int *num_el,
 void sensors_add_array_els(const void *els, int nr_els, void *list,
 			   int *num_el, int *max_el, int el_size);
 
+/* Return the time in milliseconds, from a clock which never goes back */
+long long sensors_get_time_ms(void);
+/* Same in microseconds */
+long long sensors_get_time_us(void);
+/* Same in nanoseconds */
+long long sensors_get_time_ns(void);
+
 #define ARRAY_SIZE(arr)	(int)(sizeof(arr) / sizeof((arr)[0]))
 
 #endif /* def LIB_SENSORS_GENERAL_H */
@@ -40,11 +40,24 @@
 #include "sysfs.h"
 #include "scanner.h"
 #include "init.h"
+#include "notify.h"
+#include "alarm.h"
+#include "schema.h"
+#include "watch.h"
+#include "shm.h"
+#include "virtual.h"
+#include "trace.h"
+#include "probes.h"
 
 #define DEFAULT_CONFIG_FILE	ETCDIR "/sensors3.conf"
 #define ALT_CONFIG_FILE		ETCDIR "/sensors.conf"
 #define DEFAULT_CONFIG_DIR	ETCDIR "/sensors.d"
 
+SENSORS_PROBE_DEFINE(discovery_start);
+SENSORS_PROBE_DEFINE(discovery_done);
+SENSORS_PROBE_DEFINE(config_start);
+SENSORS_PROBE_DEFINE(config_done);
+
 /* Wrapper around sensors_yyparse(), which clears the locale so that
    the decimal numbers are always parsed properly. */
 static int sensors_parse(void)
@@ -102,6 +115,7 @@ static int parse_config(FILE *input, const char *name)
 		sensors_add_config_files(&name_copy);
 	} else
 		name_copy = NULL;
+	SENSORS_PROBE1(config_start, name ? name : "");
 
 	if (sensors_scanner_init(input, name_copy)) {
 		err = -SENSORS_ERR_PARSE;
@@ -118,6 +132,7 @@ static int parse_config(FILE *input, const char *name)
 
 exit_cleanup:
 	free_config_busses();
+	SENSORS_PROBE2(config_done, name ? name : "", err);
 	return err;
 }
 
@@ -184,8 +199,11 @@ int sensors_init(FILE *input)
 
 	if (!sensors_init_sysfs())
 		return -SENSORS_ERR_KERNEL;
-	if ((res = sensors_read_sysfs_bus()) ||
-	    (res = sensors_read_sysfs_chips()))
+	SENSORS_PROBE0(discovery_start);
+	if (!(res = sensors_read_sysfs_bus()))
+		res = sensors_read_sysfs_chips();
+	SENSORS_PROBE2(discovery_done, sensors_proc_chips_count, res);
+	if (res)
 		goto exit_cleanup;
 
 	if (input) {
@@ -217,6 +235,9 @@ int sensors_init(FILE *input)
 			goto exit_cleanup;
 	}
 
+	sensors_bind_virtuals();
+	sensors_bind_computes();
+	sensors_bind_options();
 	return 0;
 
 exit_cleanup:
@@ -240,6 +261,23 @@ static void free_chip_features(sensors_chip_features *features)
 	for (i = 0; i < features->feature_count; i++)
 		free(features->feature[i].name);
 	free(features->feature);
+	free(features->cache);
+	sensors_free_chip_state(features->state);
+	free(features->pm_path);
+	free(features->ignored);
+	free(features->compute);
+	free(features->eval_order);
+	free(features->cyclic);
+	free(features->raw);
+	free(features->rolling);
+	free(features->stats);
+	if (features->sources) {
+		for (i = 0; i < features->subfeature_count; i++) {
+			free(features->sources[i].chip);
+			free(features->sources[i].subfeature);
+		}
+		free(features->sources);
+	}
 }
 
 static void free_label(sensors_label *label)
@@ -252,6 +290,8 @@ void sensors_free_expr(sensors_expr *expr)
 {
 	if (expr->kind == sensors_kind_var)
 		free(expr->data.var);
+	else if (expr->kind == sensors_kind_table)
+		free(expr->data.table.points);
 	else if (expr->kind == sensors_kind_sub) {
 		if (expr->data.subexpr.sub1)
 			sensors_free_expr(expr->data.subexpr.sub1);
@@ -279,14 +319,27 @@ static void free_ignore(sensors_ignore *ignore)
 	free(ignore->name);
 }
 
+static void free_option(sensors_option *option)
+{
+	free(option->name);
+}
+
+void sensors_free_chip_name_list(sensors_chip_name_list *list)
+{
+	int i;
+
+	for (i = 0; i < list->fits_count; i++)
+		free_chip_name(&list->fits[i]);
+	free(list->fits);
+	list->fits = NULL;
+	list->fits_count = list->fits_max = 0;
+}
+
 static void free_chip(sensors_chip *chip)
 {
 	int i;
 
-	for (i = 0; i < chip->chips.fits_count; i++)
-		free_chip_name(&chip->chips.fits[i]);
-	free(chip->chips.fits);
-	chip->chips.fits_count = chip->chips.fits_max = 0;
+	sensors_free_chip_name_list(&chip->chips);
 
 	for (i = 0; i < chip->labels_count; i++)
 		free_label(&chip->labels[i]);
@@ -307,12 +360,43 @@ static void free_chip(sensors_chip *chip)
 		free_ignore(&chip->ignores[i]);
 	free(chip->ignores);
 	chip->ignores_count = chip->ignores_max = 0;
+
+	for (i = 0; i < chip->options_count; i++)
+		free_option(&chip->options[i]);
+	free(chip->options);
+	chip->options_count = chip->options_max = 0;
+}
+
+static void free_aggregate(sensors_aggregate *aggregate)
+{
+	free(aggregate->name);
+	free(aggregate->pattern);
+	sensors_free_chip_name_list(&aggregate->chips);
+}
+
+static void free_virtual(sensors_virtual *virtual)
+{
+	int i;
+
+	free(virtual->name);
+	for (i = 0; i < virtual->aggregates_count; i++)
+		free_aggregate(&virtual->aggregates[i]);
+	free(virtual->aggregates);
+	virtual->aggregates_count = virtual->aggregates_max = 0;
 }
 
 void sensors_cleanup(void)
 {
 	int i;
 
+	sensors_sampler_stop();
+	sensors_cleanup_watches();
+	sensors_cleanup_alarm_fd();
+	sensors_cleanup_alarms();
+	sensors_cleanup_schema();
+	sensors_cleanup_shm();
+	sensors_trace_flush();
+
 	for (i = 0; i < sensors_proc_chips_count; i++) {
 		free_chip_name(&sensors_proc_chips[i].chip);
 		free_chip_features(&sensors_proc_chips[i]);
@@ -328,6 +412,13 @@ void sensors_cleanup(void)
 	sensors_config_chips_count = sensors_config_chips_max = 0;
 	sensors_config_chips_subst = 0;
 
+	for (i = 0; i < sensors_config_virtuals_count; i++)
+		free_virtual(&sensors_config_virtuals[i]);
+	free(sensors_config_virtuals);
+	sensors_config_virtuals = NULL;
+	sensors_config_virtuals_count = sensors_config_virtuals_max = 0;
+	sensors_config_virtuals_subst = 0;
+
 	for (i = 0; i < sensors_proc_bus_count; i++)
 		free_bus(&sensors_proc_bus[i]);
 	free(sensors_proc_bus);
@@ -24,5 +24,6 @@
 #include "data.h"
 
 void sensors_free_expr(sensors_expr *expr);
+void sensors_free_chip_name_list(sensors_chip_name_list *list);
 
 #endif /* def LIB_SENSORS_INIT_H */
@@ -0,0 +1,184 @@
+/*
+    notify.c - Part of libsensors, a Linux library for reading sensor data.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#include <sys/types.h>
+#include <sys/epoll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "access.h"
+#include "general.h"
+#include "notify.h"
+
+#define EVENTS_MAX	16
+
+/* One watched alarm attribute. The kernel signals a change with
+   sysfs_notify(), which shows as POLLPRI | POLLERR on the open file
+   until the attribute is read again. */
+typedef struct sensors_alarm_watch {
+	int fd;
+	const sensors_chip_features *chip;
+	const sensors_subfeature *subfeature;
+	int value;
+} sensors_alarm_watch;
+
+static sensors_alarm_watch *alarm_watches;
+static int alarm_watches_count;
+static int alarm_watches_max;
+static int alarm_epoll_fd = -1;
+
+#define alarm_watches_add(el) sensors_add_array_el( \
+	(el), &alarm_watches, &alarm_watches_count, \
+	&alarm_watches_max, sizeof(sensors_alarm_watch))
+
+/* Read the current value of an alarm attribute from its open file. This
+   also acknowledges any pending notification. Returns 0 on success, <0
+   on error. */
+static int read_alarm(int fd, int *value)
+{
+	char buf[32];
+	ssize_t len;
+
+	len = pread(fd, buf, sizeof(buf) - 1, 0);
+	if (len < 0)
+		return errno == EIO ? -SENSORS_ERR_IO : -SENSORS_ERR_ACCESS_R;
+	buf[len] = '\0';
+	if (sscanf(buf, "%d", value) != 1)
+		return -SENSORS_ERR_ACCESS_R;
+	return 0;
+}
+
+static int add_alarm_watch(const sensors_chip_features *chip,
+			   const sensors_subfeature *subfeature)
+{
+	char n[NAME_MAX];
+	struct epoll_event ev;
+	sensors_alarm_watch watch;
+
+	if (!chip->chip.path)
+		return 0;	/* Virtual chip, nothing to poll */
+	snprintf(n, NAME_MAX, "%s/%s", chip->chip.path, subfeature->name);
+	watch.fd = open(n, O_RDONLY | O_CLOEXEC);
+	if (watch.fd < 0)
+		return 0;	/* Not fatal, skip this one */
+	watch.chip = chip;
+	watch.subfeature = subfeature;
+
+	/* The initial read arms the notification */
+	if (read_alarm(watch.fd, &watch.value)) {
+		close(watch.fd);
+		return 0;
+	}
+
+	ev.events = EPOLLPRI | EPOLLERR;
+	ev.data.u32 = alarm_watches_count;
+	if (epoll_ctl(alarm_epoll_fd, EPOLL_CTL_ADD, watch.fd, &ev) < 0) {
+		close(watch.fd);
+		/* EPERM means the file does not support polling */
+		return errno == EPERM ? 0 : -SENSORS_ERR_KERNEL;
+	}
+	alarm_watches_add(&watch);
+
+	return 0;
+}
+
+int sensors_get_alarm_fd(void)
+{
+	int i, j, err;
+	const sensors_chip_features *chip;
+
+	if (alarm_epoll_fd >= 0)
+		return alarm_epoll_fd;
+
+	alarm_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (alarm_epoll_fd < 0)
+		return -SENSORS_ERR_KERNEL;
+
+	for (i = 0; i < sensors_proc_chips_count; i++) {
+		chip = &sensors_proc_chips[i];
+		for (j = 0; j < chip->subfeature_count; j++) {
+			if (!(chip->subfeature[j].flags & SENSORS_MODE_R) ||
+			    !sensors_subfeature_is_alarm(&chip->subfeature[j]))
+				continue;
+			err = add_alarm_watch(chip, &chip->subfeature[j]);
+			if (err) {
+				sensors_cleanup_alarm_fd();
+				return err;
+			}
+		}
+	}
+
+	return alarm_epoll_fd;
+}
+
+int sensors_read_alarm_events(sensors_alarm_event *events, int max)
+{
+	struct epoll_event ev[EVENTS_MAX];
+	sensors_alarm_watch *watch;
+	int i, n, value, count = 0;
+
+	if (alarm_epoll_fd < 0)
+		return -SENSORS_ERR_NO_ENTRY;
+
+	if (max <= 0)
+		return 0;
+	if (max > EVENTS_MAX)
+		max = EVENTS_MAX;
+	do {
+		n = epoll_wait(alarm_epoll_fd, ev, max, 0);
+	} while (n < 0 && errno == EINTR);
+	if (n < 0)
+		return -SENSORS_ERR_KERNEL;
+
+	/* Notifications which did not fit stay pending for the next call */
+	for (i = 0; i < n; i++) {
+		watch = &alarm_watches[ev[i].data.u32];
+		if (read_alarm(watch->fd, &value) || value == watch->value)
+			continue;
+		watch->value = value;
+		events[count].chip = &watch->chip->chip;
+		events[count].subfeature = watch->subfeature;
+		events[count].value = value;
+		count++;
+	}
+
+	return count;
+}
+
+void sensors_cleanup_alarm_fd(void)
+{
+	int i;
+
+	for (i = 0; i < alarm_watches_count; i++)
+		close(alarm_watches[i].fd);
+	free(alarm_watches);
+	alarm_watches = NULL;
+	alarm_watches_count = alarm_watches_max = 0;
+
+	if (alarm_epoll_fd >= 0) {
+		close(alarm_epoll_fd);
+		alarm_epoll_fd = -1;
+	}
+}
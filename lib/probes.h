@@ -0,0 +1,68 @@
+/*
+    probes.h - Part of libsensors, a Linux library for reading sensor data.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#ifndef LIB_SENSORS_PROBES_H
+#define LIB_SENSORS_PROBES_H
+
+/* USDT probes, for bpftrace, perf or SystemTap, built if HAVE_SDT is
+   defined (make USDT=1). A probe is a nop until a tracer attaches to it.
+   Its semaphore counts the tracers attached, so that arguments which
+   cost something are only computed while someone is listening. Each
+   probe must be defined, with SENSORS_PROBE_DEFINE(), in the file which
+   fires it. The probes are listed in libsensors(3). */
+
+#ifdef HAVE_SDT
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+#define SENSORS_PROBE_DEFINE(name) \
+	unsigned short libsensors_##name##_semaphore \
+	__attribute__((section(".probes"), used))
+#define SENSORS_PROBE_ENABLED(name) \
+	__builtin_expect(libsensors_##name##_semaphore, 0)
+
+#define SENSORS_PROBE0(name)	STAP_PROBE(libsensors, name)
+#define SENSORS_PROBE1(name, a)	STAP_PROBE1(libsensors, name, a)
+#define SENSORS_PROBE2(name, a, b) \
+	STAP_PROBE2(libsensors, name, a, b)
+#define SENSORS_PROBE4(name, a, b, c, d) \
+	STAP_PROBE4(libsensors, name, a, b, c, d)
+#define SENSORS_PROBE5(name, a, b, c, d, e) \
+	STAP_PROBE5(libsensors, name, a, b, c, d, e)
+
+#else /* !HAVE_SDT */
+
+#define SENSORS_PROBE_DEFINE(name) \
+	extern unsigned short libsensors_##name##_semaphore
+#define SENSORS_PROBE_ENABLED(name)	0
+
+#define SENSORS_PROBE0(name)			do { } while (0)
+#define SENSORS_PROBE1(name, a)			do { } while (0)
+#define SENSORS_PROBE2(name, a, b)		do { } while (0)
+#define SENSORS_PROBE4(name, a, b, c, d)	do { } while (0)
+#define SENSORS_PROBE5(name, a, b, c, d, e)	do { } while (0)
+
+#endif /* HAVE_SDT */
+
+/* Values are passed to probes in thousandths, as tracers seldom handle
+   floating point */
+#define SENSORS_PROBE_MILLI(value)	((long long)((value) * 1000))
+
+#endif /* def LIB_SENSORS_PROBES_H */
@@ -0,0 +1,182 @@
+/*
+    rolling.c - Part of libsensors, a Linux library for reading sensor data.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+/* Rolling statistics over a time window, in constant memory. Each value
+   read is weighted by the time elapsed since the previous one, so reading
+   the same value twice in a row barely counts:
+   - mean and variance are exponentially weighted moving averages, with a
+     time constant of one window;
+   - quantiles are estimated by stochastic approximation, each sample
+     moving the estimate up or down by a step proportional to the
+     standard deviation;
+   - minimum and maximum are exact over the current and previous half
+     windows, so they cover between half a window and a full window. */
+
+#include <stdlib.h>
+#include <math.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "access.h"
+#include "general.h"
+#include "rolling.h"
+
+/* Quantile estimates move by this many standard deviations per window at
+   most, which lets them converge within about a window */
+#define QUANTILE_GAIN	4
+
+static const double rolling_quantiles[ROLLING_QUANTILES] = {
+	0.50, 0.95, 0.99
+};
+
+static void rolling_reset_bucket(sensors_rolling_state *state, int b,
+				 double value)
+{
+	state->min[b] = state->max[b] = value;
+	state->count[b] = 0;
+}
+
+void sensors_rolling_feed(const sensors_chip_features *chip_features,
+			  int subfeat_nr, double value)
+{
+	sensors_rolling_state *state = &chip_features->rolling[subfeat_nr];
+	int window = chip_features->rolling_window;
+	long long now = sensors_get_time_ms();
+	double alpha, diff, step;
+	int i;
+
+	if (!state->stamp || now - state->stamp >= window) {
+		/* First value, or nothing was read for a whole window: the
+		   old statistics are meaningless, start afresh */
+		state->mean = value;
+		state->var = 0;
+		for (i = 0; i < ROLLING_QUANTILES; i++)
+			state->quantile[i] = value;
+		rolling_reset_bucket(state, 0, value);
+		rolling_reset_bucket(state, 1, value);
+		state->bucket_start = now;
+	} else {
+		alpha = 1 - exp(-(double)(now - state->stamp) / window);
+		diff = value - state->mean;
+		state->mean += alpha * diff;
+		state->var = (1 - alpha) * (state->var + alpha * diff * diff);
+
+		step = QUANTILE_GAIN * alpha * sqrt(state->var);
+		for (i = 0; i < ROLLING_QUANTILES; i++) {
+			if (value > state->quantile[i])
+				state->quantile[i] += step *
+						      rolling_quantiles[i];
+			else if (value < state->quantile[i])
+				state->quantile[i] -= step *
+						      (1 - rolling_quantiles[i]);
+		}
+
+		/* Bucket 0 is the current half window, 1 the previous */
+		if (now - state->bucket_start >= window / 2) {
+			state->min[1] = state->min[0];
+			state->max[1] = state->max[0];
+			state->count[1] = state->count[0];
+			rolling_reset_bucket(state, 0, value);
+			state->bucket_start = now;
+		}
+	}
+
+	if (value < state->min[0])
+		state->min[0] = value;
+	if (value > state->max[0])
+		state->max[0] = value;
+	state->count[0]++;
+	state->stamp = now;
+}
+
+int sensors_rolling_enable(const sensors_chip_name *match, int window)
+{
+	sensors_chip_features *chip_features;
+	sensors_rolling_state *rolling;
+	int i, found = 0;
+
+	if (window < 0)
+		return -SENSORS_ERR_NO_ENTRY;
+
+	for (i = 0; i < sensors_proc_chips_count; i++) {
+		chip_features = &sensors_proc_chips[i];
+		if (match && !sensors_match_chip(&chip_features->chip, match))
+			continue;
+		found = 1;
+
+		/* Other threads may be reading the chip */
+		rolling = NULL;
+		if (window && !chip_features->rolling) {
+			rolling = calloc(chip_features->subfeature_count,
+					 sizeof(sensors_rolling_state));
+			if (!rolling)
+				sensors_fatal_error(__func__, "Out of memory");
+		}
+		sensors_lock_chip(chip_features);
+		if (!window) {
+			rolling = chip_features->rolling;
+			chip_features->rolling = NULL;
+		} else if (rolling) {
+			chip_features->rolling = rolling;
+			rolling = NULL;
+		}
+		chip_features->rolling_window = window;
+		sensors_unlock_chip(chip_features);
+		free(rolling);
+	}
+
+	return found ? 0 : -SENSORS_ERR_NO_ENTRY;
+}
+
+int sensors_rolling_get(const sensors_chip_name *name, int subfeat_nr,
+			sensors_rolling *stats)
+{
+	const sensors_chip_features *chip_features;
+	const sensors_rolling_state *state;
+	int res = -SENSORS_ERR_NO_ENTRY;
+
+	if (sensors_chip_name_has_wildcards(name))
+		return -SENSORS_ERR_WILDCARDS;
+	if (!(chip_features = sensors_lookup_chip(name)) ||
+	    subfeat_nr < 0 || subfeat_nr >= chip_features->subfeature_count)
+		return -SENSORS_ERR_NO_ENTRY;
+
+	sensors_lock_chip(chip_features);
+	if (!chip_features->rolling)
+		goto exit_unlock;
+	state = &chip_features->rolling[subfeat_nr];
+	if (!state->stamp)
+		goto exit_unlock;	/* Not read yet */
+
+	stats->count = state->count[0] + state->count[1];
+	stats->min = state->min[0] < state->min[1] ? state->min[0] :
+						     state->min[1];
+	stats->max = state->max[0] > state->max[1] ? state->max[0] :
+						     state->max[1];
+	stats->mean = state->mean;
+	stats->stddev = sqrt(state->var);
+	stats->p50 = state->quantile[0];
+	stats->p95 = state->quantile[1];
+	stats->p99 = state->quantile[2];
+	res = 0;
+
+exit_unlock:
+	sensors_unlock_chip(chip_features);
+	return res;
+}
@@ -0,0 +1,30 @@
+/*
+    rolling.h - Part of libsensors, a Linux library for reading sensor data.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#ifndef LIB_SENSORS_ROLLING_H
+#define LIB_SENSORS_ROLLING_H
+
+#include "data.h"
+
+/* Account for a new value of a subfeature in its rolling statistics. The
+   chip must be locked. */
+void sensors_rolling_feed(const sensors_chip_features *chip_features,
+			  int subfeat_nr, double value);
+
+#endif /* def LIB_SENSORS_ROLLING_H */
@@ -0,0 +1,251 @@
+/*
+    sampler.c - Part of libsensors, a Linux library for reading sensor data.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+/* The sampler reads a snapshot of the chips from its own thread at a
+   fixed rate, and stores the samples in a ring. The sampler thread is the
+   only writer. Each slot of the ring is protected by a sequence lock: the
+   writer makes the sequence number odd while it writes, and readers retry
+   if the number was odd or changed while they were reading, so readers
+   never block the writer nor each other. */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "general.h"
+#include "snapshot.h"
+#include "watch.h"
+
+#define SAMPLER_DEPTH_MAX	4096
+#define SEQ_RETRIES		64
+
+struct sampler_slot {
+	unsigned long seq;		/* Odd while the sampler writes */
+	unsigned long long nr;		/* Number of the sample, from 1 */
+	long long stamp;
+	uint64_t *value;		/* Bits of the double values */
+	int *error;
+};
+
+static struct sampler_slot *slots;
+static int slots_count;			/* 0 if the sampler isn't running */
+static int values_count;
+static unsigned long long last_nr;	/* Last complete sample */
+
+static sensors_snapshot *sampler_snapshot;
+static double *sampler_value;
+static int *sampler_error;
+static int sampler_period;
+
+static pthread_t sampler_thread;
+static pthread_mutex_t sampler_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sampler_cond;
+static int sampler_stop;
+
+static void sampler_store(unsigned long long nr, long long stamp)
+{
+	struct sampler_slot *slot = &slots[nr % slots_count];
+	unsigned long seq;
+	uint64_t bits;
+	int i;
+
+	seq = slot->seq;
+	__atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	for (i = 0; i < values_count; i++) {
+		memcpy(&bits, &sampler_value[i], sizeof(bits));
+		__atomic_store_n(&slot->value[i], bits, __ATOMIC_RELAXED);
+		__atomic_store_n(&slot->error[i], sampler_error[i],
+				 __ATOMIC_RELAXED);
+	}
+	__atomic_store_n(&slot->nr, nr, __ATOMIC_RELAXED);
+	__atomic_store_n(&slot->stamp, stamp, __ATOMIC_RELAXED);
+	__atomic_store_n(&slot->seq, seq + 2, __ATOMIC_RELEASE);
+
+	__atomic_store_n(&last_nr, nr, __ATOMIC_RELEASE);
+}
+
+static void *sampler_worker(void *arg)
+{
+	struct timespec next;
+	unsigned long long nr = 0;
+	long long now, due;
+	int stop = 0;
+	(void)arg; /* hide warning */
+
+	due = sensors_get_time_ms();
+	while (!stop) {
+		sensors_snapshot_read(sampler_snapshot);
+		sensors_snapshot_copy(sampler_snapshot, sampler_value,
+				      sampler_error);
+		now = sensors_get_time_ms();
+		sampler_store(++nr, now);
+		sensors_watch_sample(sampler_value, sampler_error);
+
+		/* Don't try to catch up if we fell behind */
+		due += sampler_period;
+		if (due < now)
+			due = now;
+		next.tv_sec = due / 1000;
+		next.tv_nsec = (due % 1000) * 1000000;
+
+		pthread_mutex_lock(&sampler_lock);
+		while (!sampler_stop &&
+		       pthread_cond_timedwait(&sampler_cond, &sampler_lock,
+					      &next) != ETIMEDOUT)
+			;
+		stop = sampler_stop;
+		pthread_mutex_unlock(&sampler_lock);
+	}
+	return NULL;
+}
+
+static void sampler_free(void)
+{
+	int i;
+
+	if (slots) {
+		for (i = 0; i < slots_count; i++) {
+			free(slots[i].value);
+			free(slots[i].error);
+		}
+		free(slots);
+		slots = NULL;
+	}
+	slots_count = 0;
+	free(sampler_value);
+	free(sampler_error);
+	sampler_value = NULL;
+	sampler_error = NULL;
+	sensors_snapshot_free(sampler_snapshot);
+	sampler_snapshot = NULL;
+}
+
+int sensors_sampler_start(const sensors_chip_name *match, int period,
+			  int depth)
+{
+	pthread_condattr_t attr;
+	int i;
+
+	if (period <= 0 || depth <= 0 || depth > SAMPLER_DEPTH_MAX)
+		return -SENSORS_ERR_NO_ENTRY;
+	sensors_sampler_stop();
+
+	values_count = 0;
+	for (i = 0; i < sensors_proc_chips_count; i++)
+		values_count += sensors_proc_chips[i].subfeature_count;
+
+	/* One spare slot, the one being written */
+	slots_count = depth + 1;
+	slots = calloc(slots_count, sizeof(struct sampler_slot));
+	sampler_value = malloc((values_count + 1) * sizeof(double));
+	sampler_error = malloc((values_count + 1) * sizeof(int));
+	if (!slots || !sampler_value || !sampler_error)
+		sensors_fatal_error(__func__, "Out of memory");
+	for (i = 0; i < slots_count; i++) {
+		slots[i].value = calloc(values_count + 1, sizeof(uint64_t));
+		slots[i].error = calloc(values_count + 1, sizeof(int));
+		if (!slots[i].value || !slots[i].error)
+			sensors_fatal_error(__func__, "Out of memory");
+	}
+	sampler_snapshot = sensors_snapshot_new(match);
+	sampler_period = period;
+	last_nr = 0;
+
+	/* Timeouts are computed from the monotonic clock */
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&sampler_cond, &attr);
+	pthread_condattr_destroy(&attr);
+	sampler_stop = 0;
+
+	if (pthread_create(&sampler_thread, NULL, sampler_worker, NULL)) {
+		pthread_cond_destroy(&sampler_cond);
+		sampler_free();
+		return -SENSORS_ERR_KERNEL;
+	}
+	return 0;
+}
+
+/* Lock-free against the sampler thread, but not against start and stop,
+   which free the ring */
+int sensors_sampler_read(sensors_sample *samples, int n)
+{
+	const struct sampler_slot *slot;
+	unsigned long long nr, last;
+	unsigned long seq;
+	uint64_t bits;
+	int i, retries, count = 0;
+
+	if (!slots_count)
+		return -SENSORS_ERR_NO_ENTRY;
+
+	last = __atomic_load_n(&last_nr, __ATOMIC_ACQUIRE);
+	for (; count < n && count < slots_count - 1 &&
+	       (unsigned long long)count < last; count++) {
+		nr = last - count;
+		slot = &slots[nr % slots_count];
+		for (retries = 0; retries < SEQ_RETRIES; retries++) {
+			seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+			if (seq & 1)
+				continue;
+			for (i = 0; i < values_count; i++) {
+				bits = __atomic_load_n(&slot->value[i],
+						       __ATOMIC_RELAXED);
+				memcpy(&samples[count].value[i], &bits,
+				       sizeof(bits));
+				samples[count].error[i] =
+					__atomic_load_n(&slot->error[i],
+							__ATOMIC_RELAXED);
+			}
+			samples[count].nr = __atomic_load_n(&slot->nr,
+							    __ATOMIC_RELAXED);
+			samples[count].stamp =
+				__atomic_load_n(&slot->stamp, __ATOMIC_RELAXED);
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == seq)
+				break;
+		}
+		/* Give up on samples the sampler overwrote meanwhile */
+		if (retries == SEQ_RETRIES || samples[count].nr != nr)
+			break;
+	}
+
+	return count;
+}
+
+void sensors_sampler_stop(void)
+{
+	if (!slots_count)
+		return;
+
+	pthread_mutex_lock(&sampler_lock);
+	sampler_stop = 1;
+	pthread_cond_signal(&sampler_cond);
+	pthread_mutex_unlock(&sampler_lock);
+	pthread_join(sampler_thread, NULL);
+
+	pthread_cond_destroy(&sampler_cond);
+	sampler_free();
+}
@@ -0,0 +1,188 @@
+/*
+    schema.c - Part of libsensors, a Linux library for reading sensor data.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <pthread.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "access.h"
+#include "general.h"
+#include "schema.h"
+
+#define FNV_OFFSET_BASIS	0xcbf29ce484222325ULL
+#define FNV_PRIME		0x100000001b3ULL
+
+/* One metric per subfeature of each detected chip, in chip order. The
+   metrics of chip i start at schema_first[i]. Built on first use, by a
+   single thread. */
+static pthread_mutex_t schema_lock = PTHREAD_MUTEX_INITIALIZER;
+static sensors_metric *schema;
+static int schema_count = -1;	/* -1 until the schema is built */
+static int *schema_first;
+static char **schema_strings;	/* all the strings we allocated */
+static int schema_strings_count;
+static int schema_strings_max;
+
+static unsigned long long fnv1a(unsigned long long hash, const char *s)
+{
+	for (; *s; s++) {
+		hash ^= (unsigned char)*s;
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+static const char *schema_keep(char *s)
+{
+	if (!s)
+		sensors_fatal_error(__func__, "Out of memory");
+	sensors_add_array_el(&s, &schema_strings, &schema_strings_count,
+			     &schema_strings_max, sizeof(char *));
+	return s;
+}
+
+/* I2C bus numbers are assigned dynamically, so the adapter name stands for
+   the bus number in the identity of a chip, as in bus statements. Unless
+   several adapters have the same name, which leaves us with the number. */
+static void schema_chip_identity(const sensors_chip_name *chip, char *buf,
+				 size_t size)
+{
+	const char *adapter = NULL;
+	int i, count = 0;
+
+	if (chip->bus.type == SENSORS_BUS_TYPE_I2C &&
+	    (adapter = sensors_get_adapter_name(&chip->bus))) {
+		for (i = 0; i < sensors_proc_bus_count; i++)
+			if (sensors_proc_bus[i].bus.type == chip->bus.type &&
+			    !strcmp(sensors_proc_bus[i].adapter, adapter))
+				count++;
+	}
+	if (count == 1)
+		snprintf(buf, size, "%s-i2c-%s-%02x", chip->prefix, adapter,
+			 chip->addr);
+	else if (sensors_snprintf_chip_name(buf, size, chip) < 0)
+		snprintf(buf, size, "%s", chip->prefix);
+}
+
+static void sensors_build_schema(void)
+{
+	const sensors_chip_features *chip;
+	const sensors_subfeature *subfeature;
+	sensors_metric *metric;
+	const char **labels;
+	const char *chip_name;
+	char buf[NAME_MAX], identity[NAME_MAX];
+	int i, j, total = 0;
+
+	for (i = 0; i < sensors_proc_chips_count; i++)
+		total += sensors_proc_chips[i].subfeature_count;
+	schema = calloc(total + 1, sizeof(sensors_metric));
+	schema_first = malloc((sensors_proc_chips_count + 1) * sizeof(int));
+	if (!schema || !schema_first)
+		sensors_fatal_error(__func__, "Out of memory");
+
+	schema_count = 0;
+	for (i = 0; i < sensors_proc_chips_count; i++) {
+		chip = &sensors_proc_chips[i];
+		schema_first[i] = schema_count;
+
+		if (sensors_snprintf_chip_name(buf, sizeof(buf),
+					       &chip->chip) < 0)
+			snprintf(buf, sizeof(buf), "%s", chip->chip.prefix);
+		chip_name = schema_keep(strdup(buf));
+		schema_chip_identity(&chip->chip, identity, sizeof(identity));
+
+		labels = malloc((chip->feature_count + 1) * sizeof(char *));
+		if (!labels)
+			sensors_fatal_error(__func__, "Out of memory");
+		for (j = 0; j < chip->feature_count; j++)
+			labels[j] = schema_keep(sensors_get_label(&chip->chip,
+							&chip->feature[j]));
+
+		for (j = 0; j < chip->subfeature_count; j++) {
+			subfeature = &chip->subfeature[j];
+			metric = &schema[schema_count++];
+
+			/* Labels can be changed in the configuration file,
+			   so they are not part of the identity */
+			metric->id = fnv1a(fnv1a(fnv1a(FNV_OFFSET_BASIS,
+						       identity), "/"),
+					   subfeature->name);
+			metric->chip = &chip->chip;
+			metric->feature = &chip->feature[subfeature->mapping];
+			metric->subfeature = subfeature;
+			metric->chip_name = chip_name;
+			metric->label = labels[subfeature->mapping];
+			snprintf(buf, sizeof(buf), "%s/%s/%s", chip_name,
+				 metric->label, subfeature->name);
+			metric->key = schema_keep(strdup(buf));
+		}
+		free(labels);
+	}
+}
+
+const sensors_metric *sensors_get_schema(int *count)
+{
+	pthread_mutex_lock(&schema_lock);
+	if (schema_count < 0)
+		sensors_build_schema();
+	pthread_mutex_unlock(&schema_lock);
+	*count = schema_count;
+	return schema;
+}
+
+const sensors_metric *sensors_get_metric(const sensors_chip_name *name,
+					 int subfeat_nr)
+{
+	const sensors_chip_features *chip;
+	int nr;
+
+	if (sensors_chip_name_has_wildcards(name) ||
+	    !(chip = sensors_lookup_chip(name)))
+		return NULL;
+	if (subfeat_nr < 0 || subfeat_nr >= chip->subfeature_count)
+		return NULL;
+
+	pthread_mutex_lock(&schema_lock);
+	if (schema_count < 0)
+		sensors_build_schema();
+	pthread_mutex_unlock(&schema_lock);
+	nr = chip - sensors_proc_chips;
+	return &schema[schema_first[nr] + subfeat_nr];
+}
+
+void sensors_cleanup_schema(void)
+{
+	int i;
+
+	for (i = 0; i < schema_strings_count; i++)
+		free(schema_strings[i]);
+	free(schema_strings);
+	schema_strings = NULL;
+	schema_strings_count = schema_strings_max = 0;
+
+	free(schema);
+	free(schema_first);
+	schema = NULL;
+	schema_first = NULL;
+	schema_count = -1;
+}
@@ -31,7 +31,7 @@
    when the API or ABI breaks), the third digit is incremented to track small
    API additions like new flags / enum values. The second digit is for tracking
    larger additions like new methods. */
-#define SENSORS_API_VERSION		0x500
+#define SENSORS_API_VERSION		0x510
 
 #define SENSORS_CHIP_NAME_PREFIX_ANY	NULL
 #define SENSORS_CHIP_NAME_ADDR_ANY	(-1)
@@ -75,6 +75,22 @@ typedef struct sensors_chip_name {
    calling sensors_init() again. */
 int sensors_init(FILE *input);
 
+/* Read the chips from a directory laid out like sysfs instead of /sys,
+   for testing. Must be called before sensors_init(). NULL restores the
+   default, which is the SENSORS_SYSFS_ROOT environment variable if set,
+   /sys otherwise. Returns 0 on success, <0 on failure. */
+int sensors_set_sysfs_root(const char *path);
+
+/* Record every access to the attribute files of the chips, with its
+   result and latency, to a trace file, or replay the accesses recorded
+   in a trace file instead of accessing the files. Returns 0 on success,
+   <0 on failure. */
+#define SENSORS_TRACE_RECORD	0x01
+#define SENSORS_TRACE_REPLAY	0x02
+#define SENSORS_TRACE_NO_DELAY	0x04	/* replay with no latency */
+int sensors_trace_start(const char *path, int flags);
+void sensors_trace_stop(void);
+
 /* Clean-up function: You can't access anything after
    this, until the next sensors_init() call! */
 void sensors_cleanup(void);
@@ -112,6 +128,125 @@ char *sensors_get_label(const sensors_chip_name *name,
 int sensors_get_value(const sensors_chip_name *name, int subfeat_nr,
 		      double *value);
 
+/* Same as sensors_get_value(), but without any floating point operation:
+   the value is value * 10^exponent, for example a temperature of 42500
+   with exponent -3 for 42.5 degrees C. Compute statements are applied
+   only if they are affine transforms with decimal coefficients, otherwise
+   SENSORS_ERR_INEXACT is returned. The value is always read from the
+   chip. Returns 0 on success, <0 on failure. */
+int sensors_get_value_raw(const sensors_chip_name *name, int subfeat_nr,
+			  long long *value, int *exponent);
+
+/* Apply the compute statement of a subfeature to count raw values at once,
+   for example values recorded earlier. Raw values are in the unit of the
+   subfeature, before any compute statement. Variables of the compute
+   statement are read once, when this function is called. Polynomials
+   are evaluated in another order, so results may differ from
+   sensors_get_value() in the last bits. raw and value may be the same
+   array. Returns 0 on success, -SENSORS_ERR_DIV_ZERO if some values
+   couldn't be computed (they are set to NaN), another error (including
+   if count is negative) otherwise. */
+int sensors_compute_array(const sensors_chip_name *name, int subfeat_nr,
+			  const double *raw, double *value, int count);
+
+/* Special cache maximum age, meaning that the update interval of the
+   chip applies */
+#define SENSORS_CACHE_UPDATE_INTERVAL	(-1)
+
+/* Same as sensors_get_value(), but a value read from the same subfeature
+   at most max_age milliseconds ago may be returned instead of reading from
+   the chip again. If max_age is SENSORS_CACHE_UPDATE_INTERVAL, the update
+   interval of the chip is used, if the driver exposes it. A max_age of 0
+   forces a fresh read. This overrides the setting of
+   sensors_set_cache_max_age(). */
+int sensors_get_value_max_age(const sensors_chip_name *name, int subfeat_nr,
+			      int max_age, double *value);
+
+/* Let sensors_get_value() return cached values for all chips matching
+   match (all detected chips if match is NULL), when they were read at most
+   max_age milliseconds ago. SENSORS_CACHE_UPDATE_INTERVAL stands for the
+   update interval of each chip, if the driver exposes it. A max_age of 0
+   disables caching, which is the default. Returns 0 on success, <0 on
+   error (including if no chip matched.) */
+int sensors_set_cache_max_age(const sensors_chip_name *match, int max_age);
+
+/* Read health of a chip, as seen by libsensors */
+typedef struct sensors_chip_health {
+	int quarantined;	/* reads fail with SENSORS_ERR_QUARANTINE */
+	int failures;		/* consecutive slow reads */
+	int latency;		/* average read time, in microseconds */
+	int retry_in;		/* milliseconds until the chip is probed again */
+} sensors_chip_health;
+
+/* This reports how well reading a chip went lately. A chip with option
+   quarantine whose reads are repeatedly very slow gets quarantined: reads
+   fail right away for a while, and the chip is then probed again, at
+   exponentially growing intervals as long as it stays slow. Note that chip should
+   not contain wildcard values! Returns 0 on success, <0 on error. */
+int sensors_get_chip_health(const sensors_chip_name *name,
+			    sensors_chip_health *health);
+
+/* Rolling statistics of a subfeature */
+typedef struct sensors_rolling {
+	int count;		/* number of values in the window */
+	double min;		/* over the last half to full window */
+	double max;
+	double mean;		/* exponentially weighted over the window */
+	double stddev;
+	double p50;		/* estimated quantiles */
+	double p95;
+	double p99;
+} sensors_rolling;
+
+/* This maintains rolling statistics over window milliseconds for all
+   subfeatures of all detected chips matching match (all chips if match is
+   NULL), in constant memory. All values read from these chips are
+   accounted for, whichever function reads them, except those served from
+   the cache and those only read to compute other values. The statistics
+   start afresh when no value was read for a whole window, so the window
+   should span several read periods. A window of 0 disables the
+   statistics. Returns 0 on success, <0 on error (including if no chip
+   matched.) */
+int sensors_rolling_enable(const sensors_chip_name *match, int window);
+
+/* This reads the rolling statistics of a subfeature of a certain chip.
+   Note that chip should not contain wildcard values! Returns 0 on
+   success, <0 on error (including if no value was read yet.) */
+int sensors_rolling_get(const sensors_chip_name *name, int subfeat_nr,
+			sensors_rolling *stats);
+
+/* Read statistics of a subfeature, or of a whole chip. Histogram bucket 0
+   counts the reads which took less than 1 microsecond, bucket i the reads
+   which took between 2^(i+9) and 2^(i+10) nanoseconds, and the last
+   bucket all slower reads. */
+#define SENSORS_STATS_BUCKETS	24
+typedef struct sensors_stats {
+	unsigned long long reads;
+	unsigned long long errors;	/* reads which failed */
+	unsigned long long total_ns;	/* cumulative latency */
+	unsigned long long max_ns;
+	unsigned long long histogram[SENSORS_STATS_BUCKETS];
+} sensors_stats;
+
+/* This enables (enable != 0) or disables counting the reads from sysfs of
+   all detected chips matching match (all chips if match is NULL), and
+   their latency. Values served from the cache are not counted. Disabling
+   drops the counts. Returns 0 on success, <0 on error (including if no
+   chip matched.) */
+int sensors_stats_enable(const sensors_chip_name *match, int enable);
+
+/* This reads the read statistics of a subfeature of a certain chip, or
+   of the whole chip if subfeat_nr is -1. Note that chip should not
+   contain wildcard values! Returns 0 on success, <0 on error (including
+   if the statistics are not enabled.) */
+int sensors_get_stats(const sensors_chip_name *name, int subfeat_nr,
+		      sensors_stats *stats);
+
+/* This resets the read statistics of all chips matching match (all chips
+   if match is NULL) to zero. Returns 0 on success, <0 on error (including
+   if no chip matched.) */
+int sensors_reset_stats(const sensors_chip_name *match);
+
 /* Set the value of a subfeature of a certain chip. Note that chip should not
    contain wildcard values! This function will return 0 on success, and <0
    on failure. */
@@ -309,6 +444,215 @@ sensors_get_subfeature(const sensors_chip_name *name,
 		       const sensors_feature *feature,
 		       sensors_subfeature_type type);
 
+/* Features and subfeatures of a chip, as arrays. The subfeatures of a
+   main feature are contiguous, starting at its first_subfeature, up to
+   the first subfeature with a different mapping. ignored[i] is set if
+   main feature i is ignored by the configuration. */
+typedef struct sensors_chip_layout {
+	const sensors_feature *features;
+	int feature_count;
+	const sensors_subfeature *subfeatures;
+	int subfeature_count;
+	const char *ignored;
+} sensors_chip_layout;
+
+/* This returns the features and subfeatures of a certain chip at once,
+   so that they can be walked without a lookup per feature. The arrays
+   are valid until sensors_cleanup() is called. Do not try to change
+   them; you will corrupt internal data structures. Note that chip
+   should not contain wildcard values! Returns 0 on success, <0 on
+   error. */
+int sensors_get_chip_layout(const sensors_chip_name *name,
+			    sensors_chip_layout *layout);
+
+/* Description of a subfeature, for exporters keying values by integer */
+typedef struct sensors_metric {
+	unsigned long long id;		/* stable hash of chip and subfeature */
+	const sensors_chip_name *chip;
+	const sensors_feature *feature;
+	const sensors_subfeature *subfeature;
+	const char *chip_name;		/* as per sensors_snprintf_chip_name() */
+	const char *label;		/* as per sensors_get_label() */
+	const char *key;		/* chip_name/label/subfeature name */
+} sensors_metric;
+
+/* This returns the metrics of all subfeatures of all detected chips, and
+   stores their number into count. Metrics are in chip order, and in
+   subfeature number order for each chip. The id of a metric is a 64-bit
+   FNV-1a hash of the chip name and subfeature name, so it stays the same
+   across runs and configuration changes. I2C bus numbers may change
+   across boots, so the name of the adapter replaces the bus number,
+   unless several adapters have the same name. The schema is built on
+   first call, in a thread-safe way, and stays valid until
+   sensors_cleanup(). Do not try to change the returned structures; you
+   will corrupt internal data structures. */
+const sensors_metric *sensors_get_schema(int *count);
+
+/* This returns the metric of a subfeature of a certain chip, or NULL if
+   it doesn't exist. Note that chip should not contain wildcard values! */
+const sensors_metric *sensors_get_metric(const sensors_chip_name *name,
+					 int subfeat_nr);
+
+/* A change of an alarm subfeature, as reported by
+   sensors_read_alarm_events() */
+typedef struct sensors_alarm_event {
+	const sensors_chip_name *chip;
+	const sensors_subfeature *subfeature;
+	int value;
+} sensors_alarm_event;
+
+/* This returns a file descriptor which can be passed to poll() or select().
+   It signals readability when the kernel notifies a change of an alarm
+   subfeature of any detected chip. Only drivers which call sysfs_notify()
+   on their alarm attributes generate such notifications. The descriptor
+   belongs to the library and is closed by sensors_cleanup(). Returns the
+   file descriptor on success, <0 on error. */
+int sensors_get_alarm_fd(void);
+
+/* This stores into events, up to max entries, the alarm subfeatures
+   which changed value since they were last seen. It never blocks.
+   Returns the number of events stored, <0 on error. */
+int sensors_read_alarm_events(sensors_alarm_event *events, int max);
+
+/* Number of unsigned longs needed for a bitmap of n alarms */
+#define SENSORS_ALARM_LONGS(n) \
+	(((n) + 8 * sizeof(unsigned long) - 1) / (8 * sizeof(unsigned long)))
+
+/* This returns the number of alarm subfeatures of all detected chips, that
+   is the number of bits of an alarm bitmap. */
+int sensors_get_alarm_count(void);
+
+/* This reads all alarm subfeatures of all detected chips into bitmap,
+   which must hold SENSORS_ALARM_LONGS(sensors_get_alarm_count()) longs.
+   Alarms which can't be read are reported as inactive. Returns the number
+   of active alarms, <0 on error. */
+int sensors_read_alarms(unsigned long *bitmap);
+
+/* This returns the next active alarm subfeature of bitmap, and the chip
+   and feature (if feature is not NULL) it belongs to. Set nr to 0 before
+   the first call. Returns NULL when there are no more active alarms. */
+const sensors_subfeature *
+sensors_get_next_alarm(const unsigned long *bitmap, int *nr,
+		       const sensors_chip_name **name,
+		       const sensors_feature **feature);
+
+/* This reads all the readable subfeatures of all detected chips, and
+   publishes their values (before compute statements) in a shared memory
+   region. Other processes then get their values from there rather than
+   from sysfs, as long as this function is called again every period
+   milliseconds. The region is created on first call and removed by
+   sensors_cleanup(). Its name is taken from the SENSORS_SHM environment
+   variable, "/lm-sensors" by default. Fails while another running process
+   publishes under the same name. Returns 0 on success, <0 on error. */
+int sensors_shm_publish(int period);
+
+/* A snapshot holds the values of a set of chips, all read in one pass */
+typedef struct sensors_snapshot sensors_snapshot;
+
+/* This allocates a snapshot for all detected chips matching match (all
+   detected chips if match is NULL). It stays valid until sensors_cleanup()
+   is called. The threads reading the buses in parallel are started here,
+   and stopped by sensors_snapshot_free(). */
+sensors_snapshot *sensors_snapshot_new(const sensors_chip_name *match);
+
+/* This reads the values of all readable subfeatures of the chips of the
+   snapshot, reading each attribute only once even when compute statements
+   refer to it. Returns 0 on success, or the last error encountered; the
+   values which could be read are available in any case. */
+int sensors_snapshot_read(sensors_snapshot *snapshot);
+
+/* This returns the value of a subfeature, as of the last call to
+   sensors_snapshot_read(). Returns 0 on success, <0 on error (including
+   if the value could not be read.) */
+int sensors_snapshot_get_value(const sensors_snapshot *snapshot,
+			       const sensors_chip_name *name, int subfeat_nr,
+			       double *value);
+
+/* This frees a snapshot */
+void sensors_snapshot_free(sensors_snapshot *snapshot);
+
+/* A sample taken by the sampler. The caller allocates value and error,
+   with one entry per metric of sensors_get_schema(), in the same order. */
+typedef struct sensors_sample {
+	unsigned long long nr;	/* number of the sample, from 1 */
+	long long stamp;	/* time of the sample, monotonic milliseconds */
+	double *value;
+	int *error;		/* 0 if the value is valid */
+} sensors_sample;
+
+/* This starts a thread which reads a snapshot of all detected chips
+   matching match (all chips if match is NULL) every period milliseconds,
+   keeping the last depth samples. A running sampler is stopped first.
+   Returns 0 on success, <0 on error. */
+int sensors_sampler_start(const sensors_chip_name *match, int period,
+			  int depth);
+
+/* This copies up to n of the last samples taken by the sampler into
+   samples, the latest first. It never blocks nor waits for the sampler
+   thread. It must not run concurrently with sensors_sampler_start(),
+   sensors_sampler_stop() or sensors_cleanup(), which free the samples.
+   Returns the number of samples copied, <0 on error (including if the
+   sampler is not running). */
+int sensors_sampler_read(sensors_sample *samples, int n);
+
+/* This stops the sampler, if running. sensors_cleanup() does it too. */
+void sensors_sampler_stop(void);
+
+/* A software threshold on the values of a subfeature */
+typedef struct sensors_watch {
+	int below;		/* trigger below threshold rather than above */
+	double threshold;
+	double clear;		/* value to get back past to clear */
+	int count;		/* consecutive samples past threshold to trigger */
+} sensors_watch;
+
+/* A transition of a watch */
+typedef struct sensors_watch_event {
+	const sensors_chip_name *chip;
+	const sensors_subfeature *subfeature;
+	int id;			/* as returned by sensors_watch_add() */
+	int active;		/* 1 if triggered, 0 if cleared */
+	double value;
+} sensors_watch_event;
+
+typedef void (*sensors_watch_fn)(const sensors_watch_event *event,
+				 void *data);
+
+/* This adds a watch on a subfeature of a certain chip. fn, unless NULL,
+   is called with data on each transition of the watch, from the thread
+   evaluating it. Note that chip should not contain wildcard values!
+   Returns the id of the watch on success, <0 on error. */
+int sensors_watch_add(const sensors_chip_name *name, int subfeat_nr,
+		      const sensors_watch *watch, sensors_watch_fn fn,
+		      void *data);
+
+/* This adds a watch on the input of a feature for each of its limits
+   (min, max, crit...), using the hysteresis of the chip if it has one.
+   Returns the number of watches added, <0 on error. */
+int sensors_watch_add_limits(const sensors_chip_name *name,
+			     const sensors_feature *feature,
+			     sensors_watch_fn fn, void *data);
+
+/* This removes a watch. Returns 0 on success, <0 on error. */
+int sensors_watch_remove(int id);
+
+/* This reads the watched subfeatures and evaluates all watches. The
+   sampler also does it after each sample. Returns the number of
+   transitions. */
+int sensors_watch_update(void);
+
+/* This returns a file descriptor which signals readability when watch
+   transitions are waiting to be read with sensors_read_watch_events().
+   The descriptor belongs to the library and is closed by
+   sensors_cleanup(). Returns the file descriptor on success, <0 on
+   error. */
+int sensors_get_watch_fd(void);
+
+/* This stores into events, up to max entries, the oldest watch
+   transitions not read yet. It never blocks. Only the last 256
+   transitions are kept. Returns the number of events stored. */
+int sensors_read_watch_events(sensors_watch_event *events, int max);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
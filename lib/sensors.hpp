@@ -0,0 +1,541 @@
+/*
+    sensors.hpp - Part of libsensors, a Linux library for reading sensor data.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+/* C++ interface to libsensors, header only (C++11 or later). Chips,
+   features and subfeatures can be iterated over with range-based for
+   loops. Features and subfeatures are walked directly in the arrays
+   returned by sensors_get_chip_layout(), with no lookup per step.
+   Values of subfeatures whose type is known at compile time are typed
+   with their unit, for example:
+
+	sensors::library lib;
+
+	for (sensors::chip chip : sensors::chips())
+		for (sensors::feature feature : chip.features()) {
+			sensors::subfeature sub =
+				feature.find(SENSORS_SUBFEATURE_TEMP_INPUT);
+			if (sub) {
+				sensors::celsius t =
+					sub.get<SENSORS_SUBFEATURE_TEMP_INPUT>();
+				...
+			}
+		}
+
+   Functions returning a value throw sensors::error on failure, the
+   read() functions return the libsensors error code instead. */
+
+#ifndef LIB_SENSORS_SENSORS_HPP
+#define LIB_SENSORS_SENSORS_HPP
+
+#include <cstdio>
+#include <cstdlib>
+#include <ratio>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "error.h"
+#include "sensors.h"
+
+namespace sensors {
+
+class error : public std::runtime_error {
+public:
+	explicit error(int code)
+		: std::runtime_error(sensors_strerror(code)),
+		  code_(code < 0 ? -code : code) {}
+
+	/* SENSORS_ERR_* */
+	int code() const noexcept { return code_; }
+
+private:
+	int code_;
+};
+
+/* Loads the configuration (the default one if input is NULL) and detects
+   the chips for its lifetime. There must be only one at a time. */
+class library {
+public:
+	explicit library(std::FILE *input = NULL)
+	{
+		int res = sensors_init(input);
+
+		if (res)
+			throw error(res);
+	}
+	~library() { sensors_cleanup(); }
+
+	library(const library &) = delete;
+	library &operator=(const library &) = delete;
+};
+
+/*
+ * Quantities
+ */
+
+/* A value in Unit times Scale, for example quantity<volt, std::milli>
+   for millivolts. Quantities of different units don't mix, and scales
+   are converted at compile time by quantity_cast. */
+template <class Unit, class Scale = std::ratio<1> >
+class quantity {
+public:
+	typedef Unit unit;
+	typedef Scale scale;
+
+	constexpr quantity() : value_(0) {}
+	constexpr explicit quantity(double value) : value_(value) {}
+
+	constexpr double count() const { return value_; }
+
+	constexpr quantity operator-() const { return quantity(-value_); }
+	quantity &operator+=(quantity q) { value_ += q.value_; return *this; }
+	quantity &operator-=(quantity q) { value_ -= q.value_; return *this; }
+	quantity &operator*=(double x) { value_ *= x; return *this; }
+	quantity &operator/=(double x) { value_ /= x; return *this; }
+
+private:
+	double value_;
+};
+
+template <class To, class Unit, class Scale>
+constexpr To quantity_cast(quantity<Unit, Scale> q)
+{
+	typedef std::ratio_divide<Scale, typename To::scale> ratio;
+	static_assert(std::is_same<Unit, typename To::unit>::value,
+		      "Can't convert between different units");
+
+	return To(q.count() * ratio::num / ratio::den);
+}
+
+#define SENSORS_QUANTITY_OP(op)						\
+template <class U, class S>						\
+constexpr quantity<U, S> operator op(quantity<U, S> a, quantity<U, S> b) \
+{									\
+	return quantity<U, S>(a.count() op b.count());			\
+}
+SENSORS_QUANTITY_OP(+)
+SENSORS_QUANTITY_OP(-)
+#undef SENSORS_QUANTITY_OP
+
+#define SENSORS_QUANTITY_CMP(op)					\
+template <class U, class S>						\
+constexpr bool operator op(quantity<U, S> a, quantity<U, S> b)		\
+{									\
+	return a.count() op b.count();					\
+}
+SENSORS_QUANTITY_CMP(==)
+SENSORS_QUANTITY_CMP(!=)
+SENSORS_QUANTITY_CMP(<)
+SENSORS_QUANTITY_CMP(<=)
+SENSORS_QUANTITY_CMP(>)
+SENSORS_QUANTITY_CMP(>=)
+#undef SENSORS_QUANTITY_CMP
+
+template <class U, class S>
+constexpr quantity<U, S> operator*(quantity<U, S> q, double x)
+{
+	return quantity<U, S>(q.count() * x);
+}
+
+template <class U, class S>
+constexpr quantity<U, S> operator*(double x, quantity<U, S> q)
+{
+	return quantity<U, S>(x * q.count());
+}
+
+template <class U, class S>
+constexpr quantity<U, S> operator/(quantity<U, S> q, double x)
+{
+	return quantity<U, S>(q.count() / x);
+}
+
+/* Units, in which libsensors returns values */
+struct degree_celsius {};
+struct volt {};
+struct ampere {};
+struct watt {};
+struct joule {};
+struct rpm_unit {};
+struct percent_rh {};
+struct second {};
+
+typedef quantity<degree_celsius> celsius;
+typedef quantity<volt> volts;
+typedef quantity<volt, std::milli> millivolts;
+typedef quantity<ampere> amperes;
+typedef quantity<ampere, std::milli> milliamperes;
+typedef quantity<watt> watts;
+typedef quantity<watt, std::milli> milliwatts;
+typedef quantity<joule> joules;
+typedef quantity<rpm_unit> rpm;
+typedef quantity<percent_rh> percent;
+typedef quantity<second> seconds;
+
+namespace detail {
+
+/* Unit of the values of the subfeatures of a main feature */
+template <int Feature> struct feature_unit { typedef double type; };
+template <> struct feature_unit<SENSORS_FEATURE_IN> { typedef volts type; };
+template <> struct feature_unit<SENSORS_FEATURE_FAN> { typedef rpm type; };
+template <> struct feature_unit<SENSORS_FEATURE_TEMP> { typedef celsius type; };
+template <> struct feature_unit<SENSORS_FEATURE_POWER> { typedef watts type; };
+template <> struct feature_unit<SENSORS_FEATURE_ENERGY> { typedef joules type; };
+template <> struct feature_unit<SENSORS_FEATURE_CURR> { typedef amperes type; };
+template <> struct feature_unit<SENSORS_FEATURE_HUMIDITY> { typedef percent type; };
+template <> struct feature_unit<SENSORS_FEATURE_VID> { typedef volts type; };
+template <> struct feature_unit<SENSORS_FEATURE_INTRUSION> { typedef bool type; };
+template <> struct feature_unit<SENSORS_FEATURE_BEEP_ENABLE> { typedef bool type; };
+
+/* Subfeatures 0x80 and up of each main feature are flags */
+template <int Type, bool Flag = (Type & 0x80) != 0>
+struct subfeature_unit : feature_unit<(Type >> 8)> {};
+template <int Type>
+struct subfeature_unit<Type, true> { typedef bool type; };
+
+} /* namespace detail */
+
+/* Type of the values of subfeatures of type Type: a quantity, bool for
+   alarms, faults and beep flags, double for the rest */
+template <sensors_subfeature_type Type>
+struct unit_of : detail::subfeature_unit<Type> {};
+template <> struct unit_of<SENSORS_SUBFEATURE_POWER_AVERAGE_INTERVAL> {
+	typedef seconds type;
+};
+template <> struct unit_of<SENSORS_SUBFEATURE_FAN_DIV> { typedef double type; };
+template <> struct unit_of<SENSORS_SUBFEATURE_FAN_PULSES> { typedef double type; };
+template <> struct unit_of<SENSORS_SUBFEATURE_TEMP_TYPE> { typedef double type; };
+
+/*
+ * Chips, features and subfeatures
+ */
+
+class subfeature {
+public:
+	subfeature(const sensors_chip_name *chip, const sensors_subfeature *sub)
+		: chip_(chip), sub_(sub) {}
+
+	/* Whether the subfeature exists, see feature::find() */
+	explicit operator bool() const noexcept { return sub_ != NULL; }
+
+	const sensors_subfeature *get() const noexcept { return sub_; }
+	const char *name() const noexcept { return sub_->name; }
+	int number() const noexcept { return sub_->number; }
+	sensors_subfeature_type type() const noexcept { return sub_->type; }
+	bool readable() const noexcept { return sub_->flags & SENSORS_MODE_R; }
+	bool writable() const noexcept { return sub_->flags & SENSORS_MODE_W; }
+
+	/* Returns 0 on success, <0 on error */
+	int read(double *value) const noexcept
+	{
+		return sensors_get_value(chip_, sub_->number, value);
+	}
+
+	double value() const
+	{
+		double value;
+		int res = read(&value);
+
+		if (res)
+			throw error(res);
+		return value;
+	}
+
+	/* The value, in the unit of subfeatures of type Type. The type of
+	   this subfeature must be Type. */
+	template <sensors_subfeature_type Type>
+	typename unit_of<Type>::type get() const
+	{
+		if (sub_->type != Type)
+			throw error(SENSORS_ERR_NO_ENTRY);
+		return typename unit_of<Type>::type(value());
+	}
+
+	void set(double value) const
+	{
+		int res = sensors_set_value(chip_, sub_->number, value);
+
+		if (res)
+			throw error(res);
+	}
+
+private:
+	const sensors_chip_name *chip_;
+	const sensors_subfeature *sub_;
+};
+
+/* Subfeatures of a main feature: they are contiguous, and end at the
+   first subfeature with a different mapping */
+class subfeature_range {
+public:
+	class iterator {
+	public:
+		iterator(const sensors_chip_name *chip,
+			 const sensors_subfeature *p,
+			 const sensors_subfeature *last, int mapping)
+			: chip_(chip), p_(p), last_(last), mapping_(mapping) {}
+
+		subfeature operator*() const { return subfeature(chip_, p_); }
+		iterator &operator++() { ++p_; return *this; }
+		bool operator==(const iterator &i) const
+		{
+			return p_ == i.p_ || (at_end() && i.at_end());
+		}
+		bool operator!=(const iterator &i) const { return !(*this == i); }
+
+	private:
+		bool at_end() const
+		{
+			return p_ == last_ || p_->mapping != mapping_;
+		}
+
+		const sensors_chip_name *chip_;
+		const sensors_subfeature *p_, *last_;
+		int mapping_;
+	};
+
+	subfeature_range(const sensors_chip_name *chip,
+			 const sensors_subfeature *first,
+			 const sensors_subfeature *last, int mapping)
+		: chip_(chip), first_(first), last_(last), mapping_(mapping) {}
+
+	iterator begin() const
+	{
+		return iterator(chip_, first_, last_, mapping_);
+	}
+	iterator end() const { return iterator(chip_, last_, last_, mapping_); }
+	bool empty() const { return begin() == end(); }
+
+private:
+	const sensors_chip_name *chip_;
+	const sensors_subfeature *first_, *last_;
+	int mapping_;
+};
+
+class feature {
+public:
+	feature(const sensors_chip_name *chip, const sensors_feature *feat,
+		const sensors_chip_layout *layout)
+		: chip_(chip), feat_(feat), layout_(layout) {}
+
+	const sensors_feature *get() const noexcept { return feat_; }
+	const char *name() const noexcept { return feat_->name; }
+	int number() const noexcept { return feat_->number; }
+	sensors_feature_type type() const noexcept { return feat_->type; }
+
+	std::string label() const
+	{
+		char *label = sensors_get_label(chip_, feat_);
+		std::string res;
+
+		if (!label)
+			throw error(SENSORS_ERR_NO_ENTRY);
+		res = label;
+		std::free(label);
+		return res;
+	}
+
+	subfeature_range subfeatures() const
+	{
+		return subfeature_range(chip_, layout_->subfeatures +
+					feat_->first_subfeature,
+					layout_->subfeatures +
+					layout_->subfeature_count,
+					feat_->number);
+	}
+
+	/* The subfeature of type type, false if there is none */
+	subfeature find(sensors_subfeature_type type) const
+	{
+		const sensors_subfeature *sub, *last;
+
+		last = layout_->subfeatures + layout_->subfeature_count;
+		for (sub = layout_->subfeatures + feat_->first_subfeature;
+		     sub < last && sub->mapping == feat_->number; sub++)
+			if (sub->type == type)
+				return subfeature(chip_, sub);
+		return subfeature(chip_, NULL);
+	}
+
+	/* The value of the subfeature of type Type, in its unit */
+	template <sensors_subfeature_type Type>
+	typename unit_of<Type>::type get() const
+	{
+		subfeature sub = find(Type);
+
+		if (!sub)
+			throw error(SENSORS_ERR_NO_ENTRY);
+		return typename unit_of<Type>::type(sub.value());
+	}
+
+private:
+	const sensors_chip_name *chip_;
+	const sensors_feature *feat_;
+	const sensors_chip_layout *layout_;
+};
+
+/* Main features of a chip, skipping the ignored ones */
+class feature_range {
+public:
+	class iterator {
+	public:
+		iterator(const sensors_chip_name *chip,
+			 const sensors_chip_layout *layout, int nr)
+			: chip_(chip), layout_(layout),
+			  p_(layout->features + nr),
+			  last_(layout->features + layout->feature_count),
+			  ignored_(layout->ignored + nr) { skip(); }
+
+		feature operator*() const
+		{
+			return feature(chip_, p_, layout_);
+		}
+		iterator &operator++()
+		{
+			++p_;
+			++ignored_;
+			skip();
+			return *this;
+		}
+		bool operator!=(const iterator &i) const { return p_ != i.p_; }
+		bool operator==(const iterator &i) const { return p_ == i.p_; }
+
+	private:
+		void skip()
+		{
+			while (p_ != last_ && *ignored_) {
+				++p_;
+				++ignored_;
+			}
+		}
+
+		const sensors_chip_name *chip_;
+		const sensors_chip_layout *layout_;
+		const sensors_feature *p_, *last_;
+		const char *ignored_;
+	};
+
+	explicit feature_range(const sensors_chip_name *chip) : chip_(chip)
+	{
+		int res = sensors_get_chip_layout(chip, &layout_);
+
+		if (res)
+			throw error(res);
+	}
+
+	/* The iterators and features point into the range, which must
+	   outlive them */
+	iterator begin() const { return iterator(chip_, &layout_, 0); }
+	iterator end() const
+	{
+		return iterator(chip_, &layout_, layout_.feature_count);
+	}
+
+private:
+	const sensors_chip_name *chip_;
+	sensors_chip_layout layout_;
+};
+
+class chip {
+public:
+	explicit chip(const sensors_chip_name *name) : name_(name) {}
+
+	const sensors_chip_name *get() const noexcept { return name_; }
+	const char *prefix() const noexcept { return name_->prefix; }
+	const char *path() const noexcept { return name_->path; }
+	const sensors_bus_id &bus() const noexcept { return name_->bus; }
+	int addr() const noexcept { return name_->addr; }
+
+	std::string name() const
+	{
+		char buf[256];
+		int res = sensors_snprintf_chip_name(buf, sizeof(buf), name_);
+
+		if (res < 0)
+			throw error(res);
+		return buf;
+	}
+
+	const char *adapter_name() const
+	{
+		return sensors_get_adapter_name(&name_->bus);
+	}
+
+	feature_range features() const { return feature_range(name_); }
+
+	/* Returns 0 on success, <0 on error */
+	int read(int subfeat_nr, double *value) const noexcept
+	{
+		return sensors_get_value(name_, subfeat_nr, value);
+	}
+
+	void do_sets() const
+	{
+		int res = sensors_do_chip_sets(name_);
+
+		if (res)
+			throw error(res);
+	}
+
+private:
+	const sensors_chip_name *name_;
+};
+
+/* Detected chips matching a name, all of them if it is NULL */
+class chip_range {
+public:
+	class iterator {
+	public:
+		iterator(const sensors_chip_name *match, bool end)
+			: match_(match), nr_(0), chip_(NULL)
+		{
+			if (!end)
+				++*this;
+		}
+
+		chip operator*() const { return chip(chip_); }
+		iterator &operator++()
+		{
+			chip_ = sensors_get_detected_chips(match_, &nr_);
+			return *this;
+		}
+		bool operator!=(const iterator &i) const { return chip_ != i.chip_; }
+		bool operator==(const iterator &i) const { return chip_ == i.chip_; }
+
+	private:
+		const sensors_chip_name *match_;
+		int nr_;
+		const sensors_chip_name *chip_;
+	};
+
+	explicit chip_range(const sensors_chip_name *match) : match_(match) {}
+
+	iterator begin() const { return iterator(match_, false); }
+	iterator end() const { return iterator(match_, true); }
+
+private:
+	const sensors_chip_name *match_;
+};
+
+inline chip_range chips(const sensors_chip_name *match = NULL)
+{
+	return chip_range(match);
+}
+
+} /* namespace sensors */
+
+#endif /* def LIB_SENSORS_SENSORS_HPP */
@@ -0,0 +1,468 @@
+/*
+    shm.c - Part of libsensors, a Linux library for reading sensor data.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+/* One process (typically sensord) samples all the chips and publishes the
+   raw values in a shared memory region. All other processes using
+   libsensors then read the values from there instead of sysfs, as long as
+   the publisher keeps the region up to date. The region is protected by a
+   sequence lock: the publisher makes the sequence number odd while it
+   writes, and readers retry if the number was odd or changed while they
+   were reading. */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "general.h"
+#include "access.h"
+#include "shm.h"
+
+#define SHM_DEFAULT_NAME	"/lm-sensors"
+#define SHM_MAGIC		0x4c4d5348	/* "LMSH" */
+#define SHM_VERSION		1
+#define SHM_RETRY_MS		1000	/* Between two attach attempts */
+#define SEQ_RETRIES		64
+
+struct shm_header {
+	uint32_t magic;		/* Set last, once the entries are named */
+	uint32_t version;
+	uint32_t seq;		/* Odd while the publisher writes */
+	uint32_t count;		/* Number of entries */
+	int32_t period;		/* Publishing period in ms */
+	int32_t pid;		/* Of the publisher, set first */
+	int64_t stamp;		/* CLOCK_MONOTONIC ms of the last update */
+};
+
+struct shm_entry {
+	char chip[48];		/* As printed by sensors_snprintf_chip_name */
+	char subfeature[32];
+	uint64_t value;		/* Bits of the double value */
+	int32_t error;		/* 0 or -SENSORS_ERR_* */
+	uint32_t pad;
+};
+
+/* What the publisher reads for each entry */
+struct shm_source {
+	const sensors_chip_features *chip;
+	const sensors_subfeature *subfeature;
+	double value;
+	int error;
+};
+
+static struct shm_header *shm_map;
+static size_t shm_size;
+static int shm_period;
+
+/* Publisher side */
+static struct shm_source *shm_sources;
+static int shm_sources_count;
+static int shm_sources_max;
+
+/* Reader side: entry index for each subfeature of each chip, -1 if not
+   published */
+static int **shm_slots;
+static long long shm_next_attach;
+static pthread_mutex_t shm_reader_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#define shm_sources_add(el) sensors_add_array_el( \
+	(el), &shm_sources, &shm_sources_count, \
+	&shm_sources_max, sizeof(struct shm_source))
+
+static const char *shm_name(void)
+{
+	const char *name = getenv("SENSORS_SHM");
+
+	return name && *name ? name : SHM_DEFAULT_NAME;
+}
+
+static struct shm_entry *shm_entries(void)
+{
+	return (struct shm_entry *)(shm_map + 1);
+}
+
+static void shm_detach(void)
+{
+	int i;
+
+	if (shm_slots) {
+		for (i = 0; i < sensors_proc_chips_count; i++)
+			free(shm_slots[i]);
+		free(shm_slots);
+		shm_slots = NULL;
+	}
+	if (shm_map) {
+		munmap(shm_map, shm_size);
+		shm_map = NULL;
+	}
+}
+
+/* Find the entry index of each subfeature we know of */
+static void shm_map_slots(void)
+{
+	const struct shm_entry *entries = shm_entries();
+	const sensors_subfeature *subfeature;
+	char name[sizeof(entries->chip)];
+	int i, j, chip = -1;
+
+	shm_slots = calloc(sensors_proc_chips_count, sizeof(int *));
+	if (!shm_slots)
+		sensors_fatal_error(__func__, "Out of memory");
+	for (i = 0; i < sensors_proc_chips_count; i++) {
+		shm_slots[i] = malloc(sensors_proc_chips[i].subfeature_count *
+				      sizeof(int));
+		if (!shm_slots[i])
+			sensors_fatal_error(__func__, "Out of memory");
+		for (j = 0; j < sensors_proc_chips[i].subfeature_count; j++)
+			shm_slots[i][j] = -1;
+	}
+
+	/* Entries are grouped by chip, so only look up each chip once */
+	for (i = 0; i < (int)shm_map->count; i++) {
+		if (chip < 0 || strcmp(entries[i].chip, name)) {
+			for (chip = 0; chip < sensors_proc_chips_count; chip++) {
+				sensors_snprintf_chip_name(name, sizeof(name),
+						&sensors_proc_chips[chip].chip);
+				if (!strcmp(entries[i].chip, name))
+					break;
+			}
+			if (chip == sensors_proc_chips_count) {
+				chip = -1;
+				continue;
+			}
+		}
+
+		for (j = 0; j < sensors_proc_chips[chip].subfeature_count; j++) {
+			subfeature = &sensors_proc_chips[chip].subfeature[j];
+			if (!strcmp(entries[i].subfeature, subfeature->name)) {
+				shm_slots[chip][j] = i;
+				break;
+			}
+		}
+	}
+}
+
+/* Map the region of a running publisher. Returns 0 on success, <0 if
+   there is no usable region. */
+static int shm_attach(void)
+{
+	const char *name = shm_name();
+	const struct shm_entry *entries;
+	struct stat st;
+	size_t size;
+	void *map;
+	int fd, i;
+
+	if (!strcmp(name, "none"))
+		return -SENSORS_ERR_NO_ENTRY;
+
+	fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0)
+		return -SENSORS_ERR_NO_ENTRY;
+
+	/* Only trust what root or ourselves published */
+	if (fstat(fd, &st) < 0 ||
+	    (st.st_uid != 0 && st.st_uid != geteuid()) ||
+	    (st.st_mode & (S_IWGRP | S_IWOTH)) ||
+	    st.st_size < (off_t)sizeof(struct shm_header)) {
+		close(fd);
+		return -SENSORS_ERR_ACCESS_R;
+	}
+
+	size = st.st_size;
+	map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return -SENSORS_ERR_ACCESS_R;
+	shm_map = map;
+	shm_size = size;
+
+	if (__atomic_load_n(&shm_map->magic, __ATOMIC_ACQUIRE) != SHM_MAGIC ||
+	    shm_map->version != SHM_VERSION || shm_map->period <= 0 ||
+	    shm_map->count > (size - sizeof(struct shm_header)) /
+			     sizeof(struct shm_entry))
+		goto invalid;
+
+	entries = shm_entries();
+	for (i = 0; i < (int)shm_map->count; i++)
+		if (!memchr(entries[i].chip, '\0', sizeof(entries[i].chip)) ||
+		    !memchr(entries[i].subfeature, '\0',
+			    sizeof(entries[i].subfeature)))
+			goto invalid;
+
+	shm_period = shm_map->period;
+	shm_map_slots();
+	return 0;
+
+invalid:
+	shm_detach();
+	return -SENSORS_ERR_ACCESS_R;
+}
+
+static int shm_fresh(long long now, int max_age)
+{
+	return now - __atomic_load_n(&shm_map->stamp, __ATOMIC_RELAXED) <=
+	       max_age;
+}
+
+/* Check that we are attached to an up-to-date region, attaching again if
+   needed. A publisher which stopped updating the region may have exited
+   or been restarted with a new region. */
+static int shm_reader_ready(long long now)
+{
+	if (shm_sources)
+		return 0;	/* We are the publisher */
+	if (shm_map && shm_fresh(now, 2 * shm_period))
+		return 1;
+	if (now < shm_next_attach)
+		return 0;
+	shm_next_attach = now + SHM_RETRY_MS;
+
+	shm_detach();
+	return !shm_attach() && shm_fresh(now, 2 * shm_period);
+}
+
+static int shm_read(const sensors_chip_features *chip,
+		    const sensors_subfeature *subfeature, int max_age,
+		    double *value)
+{
+	const struct shm_entry *entry;
+	long long now = sensors_get_time_ms();
+	uint32_t seq;
+	uint64_t bits;
+	int64_t stamp;
+	int i, slot, error;
+
+	if (!shm_reader_ready(now))
+		return 1;
+	slot = shm_slots[chip - sensors_proc_chips][subfeature->number];
+	if (slot < 0)
+		return 1;
+	entry = &shm_entries()[slot];
+
+	for (i = 0; i < SEQ_RETRIES; i++) {
+		seq = __atomic_load_n(&shm_map->seq, __ATOMIC_ACQUIRE);
+		if (seq & 1)
+			continue;
+		bits = __atomic_load_n(&entry->value, __ATOMIC_RELAXED);
+		error = __atomic_load_n(&entry->error, __ATOMIC_RELAXED);
+		stamp = __atomic_load_n(&shm_map->stamp, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&shm_map->seq, __ATOMIC_RELAXED) == seq)
+			break;
+	}
+	if (i == SEQ_RETRIES)
+		return 1;	/* Publisher busy or dead while writing */
+
+	if (now - stamp > (max_age > 0 ? max_age : 2 * shm_period))
+		return 1;
+	if (error)
+		return error;
+	memcpy(value, &bits, sizeof(*value));
+	return 0;
+}
+
+/* Snapshots read chips from several threads, and any of them may have to
+   attach again */
+int sensors_shm_read(const sensors_chip_features *chip,
+		     const sensors_subfeature *subfeature, int max_age,
+		     double *value)
+{
+	int res;
+
+	pthread_mutex_lock(&shm_reader_lock);
+	res = shm_read(chip, subfeature, max_age, value);
+	pthread_mutex_unlock(&shm_reader_lock);
+	return res;
+}
+
+/* Whether the region is owned by another process which is still running.
+   A region with no owner yet may be being created; it is only considered
+   stale once it has been left like that for a while. */
+static int shm_owner_alive(const char *name)
+{
+	struct shm_header *header;
+	struct stat st;
+	pid_t pid;
+	int fd;
+
+	fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0)
+		return 0;
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		return 0;
+	}
+	if (st.st_size < (off_t)sizeof(struct shm_header)) {
+		close(fd);
+		return time(NULL) - st.st_mtime <= SHM_RETRY_MS / 1000;
+	}
+	header = mmap(NULL, sizeof(struct shm_header), PROT_READ, MAP_SHARED,
+		      fd, 0);
+	close(fd);
+	if (header == MAP_FAILED)
+		return 0;
+	pid = __atomic_load_n(&header->pid, __ATOMIC_RELAXED);
+	munmap(header, sizeof(struct shm_header));
+
+	if (!pid)
+		return time(NULL) - st.st_mtime <= SHM_RETRY_MS / 1000;
+	return pid != getpid() && (!kill(pid, 0) || errno == EPERM);
+}
+
+/* Create the region, with one entry per readable subfeature */
+static int shm_create(int period)
+{
+	const char *name = shm_name();
+	struct shm_source source;
+	struct shm_entry *entries;
+	char chip_name[sizeof(entries->chip)];
+	const sensors_subfeature *subfeature;
+	int fd, i, j;
+	void *map;
+
+	if (!strcmp(name, "none"))
+		return -SENSORS_ERR_NO_ENTRY;
+
+	for (i = 0; i < sensors_proc_chips_count; i++) {
+		if (sensors_snprintf_chip_name(chip_name, sizeof(chip_name),
+				&sensors_proc_chips[i].chip) >= (int)sizeof(chip_name))
+			continue;
+		for (j = 0; j < sensors_proc_chips[i].subfeature_count; j++) {
+			subfeature = &sensors_proc_chips[i].subfeature[j];
+			if (!(subfeature->flags & SENSORS_MODE_R) ||
+			    strlen(subfeature->name) >= sizeof(entries->subfeature))
+				continue;
+			source.chip = &sensors_proc_chips[i];
+			source.subfeature = subfeature;
+			shm_sources_add(&source);
+		}
+	}
+	if (!shm_sources_count)
+		return -SENSORS_ERR_NO_ENTRY;
+
+	/* Replace the region of a previous publisher which is gone, if any,
+	   but never the region of a running one */
+	if (shm_owner_alive(name))
+		return -SENSORS_ERR_ACCESS_W;
+	shm_unlink(name);
+	fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (fd < 0)
+		return -SENSORS_ERR_ACCESS_W;
+	shm_size = sizeof(struct shm_header) +
+		   shm_sources_count * sizeof(struct shm_entry);
+	if (fchmod(fd, 0644) < 0 || ftruncate(fd, shm_size) < 0) {
+		close(fd);
+		shm_unlink(name);
+		return -SENSORS_ERR_ACCESS_W;
+	}
+	map = mmap(NULL, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		shm_unlink(name);
+		return -SENSORS_ERR_ACCESS_W;
+	}
+	shm_map = map;
+	__atomic_store_n(&shm_map->pid, getpid(), __ATOMIC_RELAXED);
+
+	entries = shm_entries();
+	for (i = 0; i < shm_sources_count; i++) {
+		sensors_snprintf_chip_name(entries[i].chip,
+					   sizeof(entries[i].chip),
+					   &shm_sources[i].chip->chip);
+		strcpy(entries[i].subfeature, shm_sources[i].subfeature->name);
+	}
+	shm_map->version = SHM_VERSION;
+	shm_map->count = shm_sources_count;
+	shm_map->period = period;
+	__atomic_store_n(&shm_map->magic, SHM_MAGIC, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+int sensors_shm_publish(int period)
+{
+	struct shm_entry *entries;
+	uint64_t bits;
+	uint32_t seq;
+	int i, err;
+
+	if (period <= 0)
+		return -SENSORS_ERR_NO_ENTRY;
+
+	if (!shm_sources) {
+		shm_detach();	/* We may have been a reader so far */
+		err = shm_create(period);
+		if (err) {
+			sensors_cleanup_shm();
+			return err;
+		}
+	}
+
+	/* Do the slow reads before taking the lock, so that readers never
+	   have to wait for the chips */
+	for (i = 0; i < shm_sources_count; i++) {
+		sensors_lock_chip(shm_sources[i].chip);
+		shm_sources[i].error = sensors_read_chip_attr(
+						shm_sources[i].chip,
+						shm_sources[i].subfeature,
+						&shm_sources[i].value);
+		sensors_unlock_chip(shm_sources[i].chip);
+	}
+
+	entries = shm_entries();
+	seq = shm_map->seq;
+	__atomic_store_n(&shm_map->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	for (i = 0; i < shm_sources_count; i++) {
+		memcpy(&bits, &shm_sources[i].value, sizeof(bits));
+		__atomic_store_n(&entries[i].value, bits, __ATOMIC_RELAXED);
+		__atomic_store_n(&entries[i].error, shm_sources[i].error,
+				 __ATOMIC_RELAXED);
+	}
+	__atomic_store_n(&shm_map->stamp, sensors_get_time_ms(),
+			 __ATOMIC_RELAXED);
+	__atomic_store_n(&shm_map->seq, seq + 2, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+void sensors_cleanup_shm(void)
+{
+	if (shm_sources) {
+		if (shm_map)
+			shm_unlink(shm_name());
+		free(shm_sources);
+		shm_sources = NULL;
+		shm_sources_count = shm_sources_max = 0;
+	}
+	shm_detach();
+	shm_next_attach = 0;
+}
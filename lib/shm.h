@@ -0,0 +1,37 @@
+/*
+    shm.h - Part of libsensors, a Linux library for reading sensor data.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#ifndef LIB_SENSORS_SHM_H
+#define LIB_SENSORS_SHM_H
+
+#include "data.h"
+
+/* Read the value of a subfeature from the shared memory region of a
+   publisher, if one is running and its value is at most max_age
+   milliseconds old (or fresh by the publisher's own standards if max_age
+   is 0). Returns 0 on success, <0 if the publisher itself failed to read
+   the value, and 1 if the value must be read from sysfs instead. */
+int sensors_shm_read(const sensors_chip_features *chip,
+		     const sensors_subfeature *subfeature, int max_age,
+		     double *value);
+
+/* Detach from, or remove if we published it, the shared memory region */
+void sensors_cleanup_shm(void);
+
+#endif /* def LIB_SENSORS_SHM_H */
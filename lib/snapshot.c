@@ -0,0 +1,412 @@
+/*
+    snapshot.c - Part of libsensors, a Linux library for reading sensor data.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+/* A snapshot holds the values of all subfeatures of a set of chips, read
+   in a single pass. Subfeatures are evaluated in dependency order, so
+   compute statements referring to other subfeatures use the values of the
+   same pass, and each attribute is read from the chip only once.
+
+   Chips are grouped by the bus they sit on. Chips on the same bus are read
+   one after the other, while different buses are read in parallel, so
+   that a slow I2C bus doesn't delay the other chips. Virtual chips are
+   evaluated last, from the values just read.
+
+   The worker threads are created along with the snapshot and wait for
+   the reads, so that reading a snapshot doesn't cost a thread creation
+   per bus. */
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "access.h"
+#include "general.h"
+#include "snapshot.h"
+#include "rolling.h"
+#include "virtual.h"
+
+#define SNAPSHOT_THREADS_MAX	8
+
+struct snapshot_chip {
+	const sensors_chip_features *chip;
+	double *value;		/* one per subfeature */
+	int *error;		/* one per subfeature, 0 if value is valid */
+	int group;		/* chips of a group are read sequentially */
+	int err;		/* last error of the last read */
+};
+
+struct sensors_snapshot {
+	struct snapshot_chip *chips;
+	int chips_count;
+	int *index;		/* snapshot chip of each detected chip, or -1 */
+	int index_count;
+	int groups_count;
+	int next_group;		/* next group to read, shared by the workers */
+
+	/* Worker threads, the calling thread of a read being one too */
+	pthread_t *threads;
+	int threads_count;
+	pthread_mutex_t lock;	/* protects the members below */
+	pthread_cond_t start;	/* signaled when a read starts */
+	pthread_cond_t done;	/* signaled when the workers are done */
+	unsigned int generation;	/* number of the current read */
+	int busy;		/* workers still reading */
+	int quit;		/* workers must exit */
+};
+
+/* Chips which can't be accessed in parallel get the same group key. The
+   key type is the bus type, or -1 for chips which are independent of
+   all others. */
+static void snapshot_group_key(const sensors_chip_features *chip, int nr,
+			       int *type, int *key)
+{
+	*type = chip->chip.bus.type;
+	switch (chip->chip.bus.type) {
+	case SENSORS_BUS_TYPE_I2C:
+		*key = chip->i2c_root;
+		break;
+	case SENSORS_BUS_TYPE_ISA:
+		*key = 0;	/* LPC bus */
+		break;
+	case SENSORS_BUS_TYPE_SPI:
+	case SENSORS_BUS_TYPE_MDIO:
+		*key = chip->chip.bus.nr;
+		break;
+	default:
+		/* PCI, virtual, ACPI, HID and SCSI devices don't contend */
+		*type = -1;
+		*key = nr;
+	}
+}
+
+static void snapshot_group_chips(sensors_snapshot *snapshot)
+{
+	int *type, *key, i, j;
+
+	type = malloc((snapshot->chips_count + 1) * sizeof(int));
+	key = malloc((snapshot->chips_count + 1) * sizeof(int));
+	if (!type || !key)
+		sensors_fatal_error(__func__, "Out of memory");
+
+	for (i = 0; i < snapshot->chips_count; i++) {
+		if (snapshot->chips[i].chip->sources) {
+			snapshot->chips[i].group = -1;	/* Virtual chip */
+			continue;
+		}
+		snapshot_group_key(snapshot->chips[i].chip, i, &type[i],
+				   &key[i]);
+		for (j = 0; j < i; j++)
+			if (snapshot->chips[j].group >= 0 &&
+			    type[j] == type[i] && key[j] == key[i])
+				break;
+		snapshot->chips[i].group = j < i ? snapshot->chips[j].group :
+					   snapshot->groups_count++;
+	}
+
+	free(type);
+	free(key);
+}
+
+static int snapshot_read_chip(struct snapshot_chip *sc)
+{
+	const sensors_chip_features *chip = sc->chip;
+	const sensors_subfeature *subfeature;
+	sensors_eval_vars vars;
+	int i, nr, err = 0;
+
+	for (i = 0; i < chip->subfeature_count; i++) {
+		if (chip->cyclic[i] &&
+		    (chip->subfeature[i].flags & SENSORS_MODE_R))
+			err = sc->error[i] = -SENSORS_ERR_RECURSION;
+		else
+			sc->error[i] = -SENSORS_ERR_ACCESS_R;
+	}
+
+	vars.value = sc->value;
+	vars.error = sc->error;
+	for (i = 0; i < chip->eval_count; i++) {
+		nr = chip->eval_order[i];
+		subfeature = &chip->subfeature[nr];
+		if (!(subfeature->flags & SENSORS_MODE_R))
+			continue;
+		sc->error[nr] = sensors_compute_value(chip, subfeature, &vars,
+						      MAX_AGE_CHIP,
+						      &sc->value[nr]);
+		if (sc->error[nr])
+			err = sc->error[nr];
+	}
+
+	return err;
+}
+
+/* Take the sources of aggregates from the snapshot, or from the chips
+   which are not part of it */
+static int snapshot_read_source(const sensors_chip_features *chip,
+				const sensors_subfeature *subfeature,
+				void *data, double *value)
+{
+	const sensors_snapshot *snapshot = data;
+	const struct snapshot_chip *sc;
+	int nr = chip - sensors_proc_chips;
+
+	if (snapshot->index[nr] < 0)
+		return sensors_compute_source(chip, subfeature, MAX_AGE_CHIP,
+					      value);
+	sc = &snapshot->chips[snapshot->index[nr]];
+	*value = sc->value[subfeature->number];
+	return sc->error[subfeature->number];
+}
+
+static int snapshot_read_virtual(sensors_snapshot *snapshot,
+				 struct snapshot_chip *sc)
+{
+	const sensors_chip_features *chip = sc->chip;
+	int i, err = 0;
+
+	sensors_lock_chip(chip);
+	for (i = 0; i < chip->subfeature_count; i++) {
+		sc->error[i] = sensors_eval_aggregate(chip, i,
+						      snapshot_read_source,
+						      snapshot, &sc->value[i]);
+		if (!sc->error[i] && chip->rolling)
+			sensors_rolling_feed(chip, i, sc->value[i]);
+		if (sc->error[i])
+			err = sc->error[i];
+	}
+	sensors_unlock_chip(chip);
+
+	return err;
+}
+
+/* Read groups of chips until there are none left */
+static void snapshot_read_groups(sensors_snapshot *snapshot)
+{
+	int group, i;
+
+	while ((group = __atomic_fetch_add(&snapshot->next_group, 1,
+					   __ATOMIC_RELAXED))
+	       < snapshot->groups_count) {
+		for (i = 0; i < snapshot->chips_count; i++)
+			if (snapshot->chips[i].group == group)
+				snapshot->chips[i].err =
+					snapshot_read_chip(&snapshot->chips[i]);
+	}
+}
+
+/* Wait for a read, take part in it, and tell the reader when done */
+static void *snapshot_worker(void *arg)
+{
+	sensors_snapshot *snapshot = arg;
+	unsigned int generation = 0;
+
+	pthread_mutex_lock(&snapshot->lock);
+	for (;;) {
+		while (snapshot->generation == generation && !snapshot->quit)
+			pthread_cond_wait(&snapshot->start, &snapshot->lock);
+		if (snapshot->quit)
+			break;
+		generation = snapshot->generation;
+		pthread_mutex_unlock(&snapshot->lock);
+
+		snapshot_read_groups(snapshot);
+
+		pthread_mutex_lock(&snapshot->lock);
+		if (!--snapshot->busy)
+			pthread_cond_signal(&snapshot->done);
+	}
+	pthread_mutex_unlock(&snapshot->lock);
+
+	return NULL;
+}
+
+/* The calling thread of a read is a worker too, so one thread less than
+   groups is enough. If we fail to create threads, the reader simply reads
+   more groups itself. */
+static void snapshot_start_workers(sensors_snapshot *snapshot)
+{
+	int count = snapshot->groups_count - 1;
+
+	if (count > SNAPSHOT_THREADS_MAX - 1)
+		count = SNAPSHOT_THREADS_MAX - 1;
+	if (count <= 0)
+		return;
+
+	snapshot->threads = malloc(count * sizeof(pthread_t));
+	if (!snapshot->threads)
+		sensors_fatal_error(__func__, "Out of memory");
+	while (snapshot->threads_count < count &&
+	       !pthread_create(&snapshot->threads[snapshot->threads_count],
+			       NULL, snapshot_worker, snapshot))
+		snapshot->threads_count++;
+}
+
+static void snapshot_stop_workers(sensors_snapshot *snapshot)
+{
+	int i;
+
+	pthread_mutex_lock(&snapshot->lock);
+	snapshot->quit = 1;
+	pthread_cond_broadcast(&snapshot->start);
+	pthread_mutex_unlock(&snapshot->lock);
+
+	for (i = 0; i < snapshot->threads_count; i++)
+		pthread_join(snapshot->threads[i], NULL);
+	free(snapshot->threads);
+}
+
+sensors_snapshot *sensors_snapshot_new(const sensors_chip_name *match)
+{
+	sensors_snapshot *snapshot;
+	struct snapshot_chip *sc;
+	const sensors_chip_name *name;
+	int nr, i;
+
+	snapshot = calloc(1, sizeof(sensors_snapshot));
+	if (!snapshot)
+		sensors_fatal_error(__func__, "Out of memory");
+	snapshot->index_count = sensors_proc_chips_count;
+	snapshot->index = malloc((sensors_proc_chips_count + 1) * sizeof(int));
+	snapshot->chips = calloc(sensors_proc_chips_count + 1,
+				 sizeof(struct snapshot_chip));
+	if (!snapshot->index || !snapshot->chips)
+		sensors_fatal_error(__func__, "Out of memory");
+
+	for (i = 0; i < sensors_proc_chips_count; i++)
+		snapshot->index[i] = -1;
+
+	for (nr = 0; (name = sensors_get_detected_chips(match, &nr));) {
+		snapshot->index[nr - 1] = snapshot->chips_count;
+
+		sc = &snapshot->chips[snapshot->chips_count++];
+		sc->chip = &sensors_proc_chips[nr - 1];
+		sc->value = calloc(sc->chip->subfeature_count, sizeof(double));
+		sc->error = malloc(sc->chip->subfeature_count * sizeof(int));
+		if (!sc->value || !sc->error)
+			sensors_fatal_error(__func__, "Out of memory");
+		for (i = 0; i < sc->chip->subfeature_count; i++)
+			sc->error[i] = -SENSORS_ERR_NO_ENTRY;	/* Not read yet */
+	}
+	snapshot_group_chips(snapshot);
+
+	pthread_mutex_init(&snapshot->lock, NULL);
+	pthread_cond_init(&snapshot->start, NULL);
+	pthread_cond_init(&snapshot->done, NULL);
+	snapshot_start_workers(snapshot);
+
+	return snapshot;
+}
+
+int sensors_snapshot_read(sensors_snapshot *snapshot)
+{
+	int i, err = 0;
+
+	pthread_mutex_lock(&snapshot->lock);
+	snapshot->next_group = 0;
+	snapshot->busy = snapshot->threads_count;
+	snapshot->generation++;
+	pthread_cond_broadcast(&snapshot->start);
+	pthread_mutex_unlock(&snapshot->lock);
+
+	snapshot_read_groups(snapshot);
+
+	pthread_mutex_lock(&snapshot->lock);
+	while (snapshot->busy)
+		pthread_cond_wait(&snapshot->done, &snapshot->lock);
+	pthread_mutex_unlock(&snapshot->lock);
+
+	for (i = 0; i < snapshot->chips_count; i++)
+		if (snapshot->chips[i].group < 0)
+			snapshot->chips[i].err =
+				snapshot_read_virtual(snapshot,
+						      &snapshot->chips[i]);
+
+	for (i = 0; i < snapshot->chips_count; i++)
+		if (snapshot->chips[i].err)
+			err = snapshot->chips[i].err;
+	return err;
+}
+
+int sensors_snapshot_get_value(const sensors_snapshot *snapshot,
+			       const sensors_chip_name *name, int subfeat_nr,
+			       double *value)
+{
+	const sensors_chip_features *chip;
+	const struct snapshot_chip *sc;
+	int nr;
+
+	if (sensors_chip_name_has_wildcards(name))
+		return -SENSORS_ERR_WILDCARDS;
+	if (!(chip = sensors_lookup_chip(name)))
+		return -SENSORS_ERR_NO_ENTRY;
+	nr = chip - sensors_proc_chips;
+	if (nr >= snapshot->index_count || snapshot->index[nr] < 0)
+		return -SENSORS_ERR_NO_ENTRY;
+	sc = &snapshot->chips[snapshot->index[nr]];
+	if (subfeat_nr < 0 || subfeat_nr >= chip->subfeature_count)
+		return -SENSORS_ERR_NO_ENTRY;
+
+	if (sc->error[subfeat_nr] &&
+	    sc->error[subfeat_nr] != -SENSORS_ERR_STALE)
+		return sc->error[subfeat_nr];
+	*value = sc->value[subfeat_nr];
+	return sc->error[subfeat_nr];
+}
+
+void sensors_snapshot_copy(const sensors_snapshot *snapshot, double *value,
+			   int *error)
+{
+	const struct snapshot_chip *sc;
+	int i, j;
+
+	for (i = 0; i < snapshot->index_count; i++) {
+		if (snapshot->index[i] < 0) {
+			for (j = 0; j < sensors_proc_chips[i].subfeature_count;
+			     j++) {
+				*value++ = 0;
+				*error++ = -SENSORS_ERR_NO_ENTRY;
+			}
+			continue;
+		}
+		sc = &snapshot->chips[snapshot->index[i]];
+		for (j = 0; j < sc->chip->subfeature_count; j++) {
+			*value++ = sc->value[j];
+			*error++ = sc->error[j];
+		}
+	}
+}
+
+void sensors_snapshot_free(sensors_snapshot *snapshot)
+{
+	int i;
+
+	if (!snapshot)
+		return;
+	snapshot_stop_workers(snapshot);
+	pthread_cond_destroy(&snapshot->done);
+	pthread_cond_destroy(&snapshot->start);
+	pthread_mutex_destroy(&snapshot->lock);
+	for (i = 0; i < snapshot->chips_count; i++) {
+		free(snapshot->chips[i].value);
+		free(snapshot->chips[i].error);
+	}
+	free(snapshot->chips);
+	free(snapshot->index);
+	free(snapshot);
+}
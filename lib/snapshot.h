@@ -0,0 +1,31 @@
+/*
+    snapshot.h - Part of libsensors, a Linux library for reading sensor data.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#ifndef LIB_SENSORS_SNAPSHOT_H
+#define LIB_SENSORS_SNAPSHOT_H
+
+#include "sensors.h"
+
+/* Copy the values and errors of all subfeatures of all detected chips
+   out of a snapshot, in chip order, as in sensors_get_schema(). Chips
+   which are not part of the snapshot get SENSORS_ERR_NO_ENTRY. */
+void sensors_snapshot_copy(const sensors_snapshot *snapshot, double *value,
+			   int *error);
+
+#endif /* def LIB_SENSORS_SNAPSHOT_H */
@@ -0,0 +1,159 @@
+/*
+    stats.c - Part of libsensors, a Linux library for reading sensor data.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+/* Read statistics of the subfeatures of the detected chips. The counters
+   are only allocated for the chips they were enabled for, so the read
+   path only pays for a pointer test otherwise. The latency histogram has
+   a bucket per power of 2 of nanoseconds, from 1 microsecond up. */
+
+#include <stdlib.h>
+#include <string.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "access.h"
+#include "stats.h"
+
+/* Bucket 0 ends at 2^STATS_FIRST_SHIFT nanoseconds */
+#define STATS_FIRST_SHIFT	10
+
+static int stats_bucket(unsigned long long ns)
+{
+	int b;
+
+	if (ns < (1ULL << STATS_FIRST_SHIFT))
+		return 0;
+	b = 64 - __builtin_clzll(ns) - STATS_FIRST_SHIFT;
+	return b < SENSORS_STATS_BUCKETS ? b : SENSORS_STATS_BUCKETS - 1;
+}
+
+void sensors_stats_account(sensors_stats *stats, int res, long long ns)
+{
+	if (ns < 0)
+		ns = 0;
+	stats->reads++;
+	if (res)
+		stats->errors++;
+	stats->total_ns += ns;
+	if ((unsigned long long)ns > stats->max_ns)
+		stats->max_ns = ns;
+	stats->histogram[stats_bucket(ns)]++;
+}
+
+int sensors_stats_enable(const sensors_chip_name *match, int enable)
+{
+	sensors_chip_features *chip_features;
+	sensors_stats *stats;
+	int i, found = 0;
+
+	for (i = 0; i < sensors_proc_chips_count; i++) {
+		chip_features = &sensors_proc_chips[i];
+		/* Virtual chips don't read from sysfs */
+		if (chip_features->sources)
+			continue;
+		if (match && !sensors_match_chip(&chip_features->chip, match))
+			continue;
+		found = 1;
+
+		/* Other threads may be reading the chip */
+		stats = NULL;
+		if (enable && !chip_features->stats) {
+			stats = calloc(chip_features->subfeature_count,
+				       sizeof(sensors_stats));
+			if (!stats)
+				sensors_fatal_error(__func__, "Out of memory");
+		}
+		sensors_lock_chip(chip_features);
+		if (!enable) {
+			stats = chip_features->stats;
+			chip_features->stats = NULL;
+		} else if (stats) {
+			chip_features->stats = stats;
+			stats = NULL;
+		}
+		sensors_unlock_chip(chip_features);
+		free(stats);
+	}
+
+	return found ? 0 : -SENSORS_ERR_NO_ENTRY;
+}
+
+static void stats_add(sensors_stats *sum, const sensors_stats *stats)
+{
+	int i;
+
+	sum->reads += stats->reads;
+	sum->errors += stats->errors;
+	sum->total_ns += stats->total_ns;
+	if (stats->max_ns > sum->max_ns)
+		sum->max_ns = stats->max_ns;
+	for (i = 0; i < SENSORS_STATS_BUCKETS; i++)
+		sum->histogram[i] += stats->histogram[i];
+}
+
+int sensors_get_stats(const sensors_chip_name *name, int subfeat_nr,
+		      sensors_stats *stats)
+{
+	const sensors_chip_features *chip_features;
+	int i;
+
+	if (sensors_chip_name_has_wildcards(name))
+		return -SENSORS_ERR_WILDCARDS;
+	if (!(chip_features = sensors_lookup_chip(name)) ||
+	    subfeat_nr < -1 || subfeat_nr >= chip_features->subfeature_count)
+		return -SENSORS_ERR_NO_ENTRY;
+
+	sensors_lock_chip(chip_features);
+	if (!chip_features->stats) {
+		sensors_unlock_chip(chip_features);
+		return -SENSORS_ERR_NO_ENTRY;
+	}
+	if (subfeat_nr >= 0) {
+		*stats = chip_features->stats[subfeat_nr];
+	} else {
+		memset(stats, 0, sizeof(*stats));
+		for (i = 0; i < chip_features->subfeature_count; i++)
+			stats_add(stats, &chip_features->stats[i]);
+	}
+	sensors_unlock_chip(chip_features);
+	return 0;
+}
+
+int sensors_reset_stats(const sensors_chip_name *match)
+{
+	sensors_chip_features *chip_features;
+	int i, found = 0;
+
+	for (i = 0; i < sensors_proc_chips_count; i++) {
+		chip_features = &sensors_proc_chips[i];
+		if (match && !sensors_match_chip(&chip_features->chip, match))
+			continue;
+
+		sensors_lock_chip(chip_features);
+		if (chip_features->stats) {
+			memset(chip_features->stats, 0,
+			       chip_features->subfeature_count *
+			       sizeof(sensors_stats));
+			found = 1;
+		}
+		sensors_unlock_chip(chip_features);
+	}
+
+	return found ? 0 : -SENSORS_ERR_NO_ENTRY;
+}
@@ -0,0 +1,29 @@
+/*
+    stats.h - Part of libsensors, a Linux library for reading sensor data.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#ifndef LIB_SENSORS_STATS_H
+#define LIB_SENSORS_STATS_H
+
+#include "sensors.h"
+
+/* Account for a read from sysfs which returned res and took ns
+   nanoseconds */
+void sensors_stats_account(sensors_stats *stats, int res, long long ns);
+
+#endif /* def LIB_SENSORS_STATS_H */
@@ -36,6 +36,8 @@
 #include "access.h"
 #include "general.h"
 #include "sysfs.h"
+#include "trace.h"
+#include "probes.h"
 
 
 /****************************************************************************/
@@ -43,6 +45,9 @@
 #define ATTR_MAX	128
 #define SYSFS_MAGIC	0x62656572
 
+SENSORS_PROBE_DEFINE(attr_read);
+SENSORS_PROBE_DEFINE(attr_write);
+
 /*
  * Read an attribute from sysfs
  * Returns a pointer to a freshly allocated string; free it yourself.
@@ -137,6 +142,7 @@ static int sysfs_foreach_busdev(const char *bus_type,
 /****************************************************************************/
 
 char sensors_sysfs_mount[NAME_MAX];
+static char *sysfs_root;	/* set by sensors_set_sysfs_root() */
 
 static
 int get_type_scaling(sensors_subfeature_type type)
@@ -167,8 +173,18 @@ int get_type_scaling(sensors_subfeature_type type)
 	}
 }
 
-static
-char *get_feature_name(sensors_feature_type ftype, char *sfname)
+/* Decimal exponent of the sysfs unit of a subfeature type, for example -3
+   for millivolts */
+int sensors_get_type_exponent(sensors_subfeature_type type)
+{
+	int scaling, exponent = 0;
+
+	for (scaling = get_type_scaling(type); scaling >= 10; scaling /= 10)
+		exponent--;
+	return exponent;
+}
+
+char *sensors_get_feature_name(sensors_feature_type ftype, const char *sfname)
 {
 	char *name, *underscore;
 
@@ -343,7 +359,6 @@ static struct feature_type_match matches[] = {
 
 /* Return the subfeature type and channel number based on the subfeature
    name */
-static
 sensors_subfeature_type sensors_subfeature_get_type(const char *name, int *nr)
 {
 	char c;
@@ -575,7 +590,7 @@ static int sensors_read_dynamic_chip(sensors_chip_features *chip,
 				prev_slot = i / feature_size;
 
 				dyn_features[fnum].name =
-					get_feature_name(ftype,
+					sensors_get_feature_name(ftype,
 						all_types[ftype].sf[i].name);
 				dyn_features[fnum].number = fnum;
 				dyn_features[fnum].first_subfeature = sfnum;
@@ -602,10 +617,37 @@ exit_free:
 	return 0;
 }
 
+int sensors_set_sysfs_root(const char *path)
+{
+	char *root = NULL;
+
+	if (path) {
+		if (strlen(path) >= NAME_MAX)
+			return -SENSORS_ERR_NO_ENTRY;
+		if (!(root = strdup(path)))
+			sensors_fatal_error(__func__, "Out of memory");
+	}
+	free(sysfs_root);
+	sysfs_root = root;
+	return 0;
+}
+
 /* returns !0 if sysfs filesystem was found, 0 otherwise */
 int sensors_init_sysfs(void)
 {
 	struct statfs statfsbuf;
+	struct stat st;
+	const char *root;
+
+	if (sensors_trace_env())
+		return 0;
+
+	/* Alternative trees, for testing, are ordinary directories */
+	root = sysfs_root ? sysfs_root : secure_getenv("SENSORS_SYSFS_ROOT");
+	if (root && *root) {
+		snprintf(sensors_sysfs_mount, NAME_MAX, "%s", root);
+		return !stat(root, &st) && S_ISDIR(st.st_mode);
+	}
 
 	snprintf(sensors_sysfs_mount, NAME_MAX, "%s", "/sys");
 	if (statfs(sensors_sysfs_mount, &statfsbuf) < 0
@@ -753,6 +795,22 @@ static int find_bus_type(const char *dev_path,
 	return ret;
 }
 
+/* Find the number of the I2C adapter a device ultimately sits on. Devices
+   behind a multiplexer are children of a mux segment adapter, itself a
+   child of the root adapter, and all share the root adapter's bus. Returns
+   -1 if the device path has no I2C adapter. */
+static int find_root_i2c_adapter(const char *dev_path)
+{
+	const char *p;
+	int nr, len;
+
+	for (p = dev_path; (p = strstr(p, "/i2c-")); p++)
+		if (sscanf(p, "/i2c-%d%n", &nr, &len) == 1 &&
+		    (p[len] == '/' || p[len] == '\0'))
+			return nr;
+	return -1;
+}
+
 /* returns: number of devices added (0 or 1) if successful, <0 otherwise */
 static int sensors_read_one_sysfs_chip(const char *dev_path,
 				       const char *dev_name,
@@ -760,6 +818,7 @@ static int sensors_read_one_sysfs_chip(const char *dev_path,
 {
 	int ret = 1;
 	int virtual = 0;
+	char *attr, n[NAME_MAX];
 	sensors_chip_features entry;
 
 	/* ignore any device without name attribute */
@@ -789,6 +848,13 @@ static int sensors_read_one_sysfs_chip(const char *dev_path,
 		entry.chip.addr = 0;
 	}
 
+	entry.i2c_root = -1;
+	if (entry.chip.bus.type == SENSORS_BUS_TYPE_I2C) {
+		entry.i2c_root = find_root_i2c_adapter(dev_path);
+		if (entry.i2c_root < 0)
+			entry.i2c_root = entry.chip.bus.nr;
+	}
+
 	if (sensors_read_dynamic_chip(&entry, hwmon_path) < 0) {
 		ret = -SENSORS_ERR_KERNEL;
 		goto exit_free;
@@ -797,6 +863,38 @@ static int sensors_read_one_sysfs_chip(const char *dev_path,
 		ret = 0;
 		goto exit_free;
 	}
+
+	/* How often the driver refreshes its values, if it tells */
+	entry.update_interval = -1;
+	if ((attr = sysfs_read_attr(hwmon_path, "update_interval"))) {
+		entry.update_interval = atoi(attr);
+		free(attr);
+	}
+	entry.cache_max_age = 0;
+	entry.cache = calloc(entry.subfeature_count,
+			     sizeof(sensors_cache_entry));
+	entry.state = sensors_new_chip_state();
+	if (!entry.cache)
+		sensors_fatal_error(__func__, "Out of memory");
+	entry.pm_path = NULL;
+	if (dev_path) {
+		snprintf(n, NAME_MAX, "%s/power/runtime_status", dev_path);
+		if (access(n, R_OK) == 0 && !(entry.pm_path = strdup(n)))
+			sensors_fatal_error(__func__, "Out of memory");
+	}
+	entry.no_wakeup = 0;
+	entry.quarantine = 0;
+	entry.ignored = NULL;
+	entry.compute = NULL;
+	entry.eval_order = NULL;
+	entry.eval_count = 0;
+	entry.raw = NULL;
+	entry.rolling_window = 0;
+	entry.rolling = NULL;
+	entry.stats = NULL;
+	entry.cyclic = NULL;
+	entry.sources = NULL;
+
 	sensors_add_proc_chips(&entry);
 
 	return ret;
@@ -914,9 +1012,8 @@ int sensors_read_sysfs_bus(void)
 	return 0;
 }
 
-int sensors_read_sysfs_attr(const sensors_chip_name *name,
-			    const sensors_subfeature *subfeature,
-			    double *value)
+static int read_attr(const sensors_chip_name *name,
+		     const sensors_subfeature *subfeature, double *value)
 {
 	char n[NAME_MAX];
 	FILE *f;
@@ -948,9 +1045,41 @@ int sensors_read_sysfs_attr(const sensors_chip_name *name,
 	return 0;
 }
 
-int sensors_write_sysfs_attr(const sensors_chip_name *name,
-			     const sensors_subfeature *subfeature,
-			     double value)
+static int read_attr_raw(const sensors_chip_name *name,
+			 const sensors_subfeature *subfeature,
+			 long long *value)
+{
+	char n[NAME_MAX];
+	FILE *f;
+
+	snprintf(n, NAME_MAX, "%s/%s", name->path, subfeature->name);
+	if ((f = fopen(n, "r"))) {
+		int res, err = 0;
+
+		errno = 0;
+		res = fscanf(f, "%lld", value);
+		if (res == EOF && errno == EIO)
+			err = -SENSORS_ERR_IO;
+		else if (res != 1)
+			err = -SENSORS_ERR_ACCESS_R;
+		res = fclose(f);
+		if (err)
+			return err;
+
+		if (res == EOF) {
+			if (errno == EIO)
+				return -SENSORS_ERR_IO;
+			else
+				return -SENSORS_ERR_ACCESS_R;
+		}
+	} else
+		return -SENSORS_ERR_KERNEL;
+
+	return 0;
+}
+
+static int write_attr(const sensors_chip_name *name,
+		      const sensors_subfeature *subfeature, double value)
 {
 	char n[NAME_MAX];
 	FILE *f;
@@ -980,3 +1109,104 @@ int sensors_write_sysfs_attr(const sensors_chip_name *name,
 
 	return 0;
 }
+
+/* Path of an attribute file in traces. Paths are relative to the sysfs
+   root, so that traces recorded from /sys can be replayed on a copy. */
+static void trace_path(char *path, size_t size, const sensors_chip_name *name,
+		       const sensors_subfeature *subfeature)
+{
+	size_t len = strlen(sensors_sysfs_mount);
+
+	if (!strncmp(name->path, sensors_sysfs_mount, len) &&
+	    name->path[len] == '/')
+		snprintf(path, size, "%s/%s", name->path + len + 1,
+			 subfeature->name);
+	else
+		snprintf(path, size, "%s/%s", name->path, subfeature->name);
+}
+
+/* Access an attribute file while the accesses are traced, either to a
+   trace file, which records them or replays them, or by a probe */
+static int trace_attr(const sensors_chip_name *name,
+		      const sensors_subfeature *subfeature, int kind,
+		      union sensors_trace_value *value)
+{
+	char path[NAME_MAX];
+	long long start, ns;
+	int err;
+
+	start = sensors_get_time_ns();
+	if (sensors_trace_mode & SENSORS_TRACE_REPLAY) {
+		trace_path(path, sizeof(path), name, subfeature);
+		err = sensors_trace_replay(path, kind, value);
+		ns = sensors_get_time_ns() - start;
+	} else {
+		switch (kind) {
+		case TRACE_READ:
+			err = read_attr(name, subfeature, &value->d);
+			break;
+		case TRACE_READ_RAW:
+			err = read_attr_raw(name, subfeature, &value->i);
+			break;
+		default:
+			err = write_attr(name, subfeature, value->d);
+			break;
+		}
+		ns = sensors_get_time_ns() - start;
+		if (sensors_trace_mode & SENSORS_TRACE_RECORD) {
+			trace_path(path, sizeof(path), name, subfeature);
+			sensors_trace_record(path, kind, err, ns, value);
+		}
+	}
+
+	if (kind == TRACE_WRITE)
+		SENSORS_PROBE4(attr_write, name->path, subfeature->name, ns,
+			       err);
+	else
+		SENSORS_PROBE4(attr_read, name->path, subfeature->name, ns,
+			       err);
+	return err;
+}
+
+int sensors_read_sysfs_attr(const sensors_chip_name *name,
+			    const sensors_subfeature *subfeature,
+			    double *value)
+{
+	union sensors_trace_value v;
+	int err;
+
+	if (!sensors_trace_mode && !SENSORS_PROBE_ENABLED(attr_read))
+		return read_attr(name, subfeature, value);
+
+	if (!(err = trace_attr(name, subfeature, TRACE_READ, &v)))
+		*value = v.d;
+	return err;
+}
+
+int sensors_read_sysfs_attr_raw(const sensors_chip_name *name,
+				const sensors_subfeature *subfeature,
+				long long *value)
+{
+	union sensors_trace_value v;
+	int err;
+
+	if (!sensors_trace_mode && !SENSORS_PROBE_ENABLED(attr_read))
+		return read_attr_raw(name, subfeature, value);
+
+	if (!(err = trace_attr(name, subfeature, TRACE_READ_RAW, &v)))
+		*value = v.i;
+	return err;
+}
+
+int sensors_write_sysfs_attr(const sensors_chip_name *name,
+			     const sensors_subfeature *subfeature,
+			     double value)
+{
+	union sensors_trace_value v;
+
+	if (!sensors_trace_mode && !SENSORS_PROBE_ENABLED(attr_write))
+		return write_attr(name, subfeature, value);
+
+	v.d = value;
+	return trace_attr(name, subfeature, TRACE_WRITE, &v);
+}
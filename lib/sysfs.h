@@ -35,6 +35,21 @@ int sensors_read_sysfs_attr(const sensors_chip_name *name,
 			    const sensors_subfeature *subfeature,
 			    double *value);
 
+/* Read the integer value out of a sysfs attribute file, unscaled */
+int sensors_read_sysfs_attr_raw(const sensors_chip_name *name,
+				const sensors_subfeature *subfeature,
+				long long *value);
+
+/* Decimal exponent of the unit of the sysfs attributes of a type */
+int sensors_get_type_exponent(sensors_subfeature_type type);
+
+/* Return the subfeature type and channel number based on the subfeature
+   name */
+sensors_subfeature_type sensors_subfeature_get_type(const char *name, int *nr);
+
+/* Name of the feature a subfeature belongs to */
+char *sensors_get_feature_name(sensors_feature_type ftype, const char *sfname);
+
 /* Write a value to a sysfs attribute file */
 int sensors_write_sysfs_attr(const sensors_chip_name *name,
 			     const sensors_subfeature *subfeature,
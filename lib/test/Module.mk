@@ -2,7 +2,11 @@ LIB_DIR		:= lib
 LIB_TEST_DIR	:= lib/test
 
 LIB_TEST_TARGETS := $(LIB_TEST_DIR)/test-scanner
-LIB_TEST_SOURCES := $(LIB_TEST_DIR)/test-scanner.c
+LIB_TEST_SOURCES := $(LIB_TEST_DIR)/test-scanner.c \
+		    $(LIB_TEST_DIR)/test-compute.c \
+		    $(LIB_TEST_DIR)/test-lib.c
+# Only built by "make check"
+LIB_TEST_CHECK_TARGETS := $(LIB_TEST_DIR)/test-compute $(LIB_TEST_DIR)/test-lib
 
 LIB_TEST_SCANNER_OBJS := \
 	$(LIB_TEST_DIR)/test-scanner.ro \
@@ -13,12 +17,22 @@ LIB_TEST_SCANNER_OBJS := \
 $(LIB_TEST_DIR)/test-scanner: $(LIB_TEST_SCANNER_OBJS)
 	$(CC) $(EXLDFLAGS) -o $@ $(LIB_TEST_SCANNER_OBJS) -Llib
 
+# The check programs link the static objects of the library, so that they
+# run without installing it
+$(LIB_TEST_CHECK_TARGETS): %: %.ro $(LIBSTOBJECTS)
+	$(CC) $(EXLDFLAGS) -o $@ $^ -lm -lrt -lpthread
+
 all-lib-test: $(LIB_TEST_TARGETS)
 user :: all-lib-test
 
+check-lib-test: $(LIB_TEST_CHECK_TARGETS)
+	$(LIB_TEST_DIR)/test-lib.sh
+check :: check-lib-test
+
 $(LIB_TEST_DIR)/test-scanner.ro: $(LIB_DIR)/data.h $(LIB_DIR)/conf.h $(LIB_DIR)/conf-parse.h $(LIB_DIR)/scanner.h
+$(LIB_TEST_CHECK_TARGETS:=.ro): $(LIB_DIR)/sensors.h $(LIB_DIR)/error.h
 
 clean-lib-test:
 	$(RM) $(LIB_TEST_DIR)/*.rd $(LIB_TEST_DIR)/*.ro 
-	$(RM) $(LIB_TEST_TARGETS)
+	$(RM) $(LIB_TEST_TARGETS) $(LIB_TEST_CHECK_TARGETS)
 clean :: clean-lib-test
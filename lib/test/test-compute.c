@@ -0,0 +1,152 @@
+/*
+    test-compute.c - Regression test driver for the libsensors compute,
+    table and virtual statements.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; version 2 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+/* Reads a configuration file, then reads or sets the given subfeatures
+   and prints the results. A value is printed both as computed and as
+   returned by sensors_get_value_raw(); after a set, the attribute file
+   is printed as written. Meant to be run on a generated tree, with
+   SENSORS_SYSFS_ROOT. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../sensors.h"
+#include "../error.h"
+
+static void parse_error(const char *err, const char *filename, int lineno)
+{
+	(void)filename;	/* The path of the test directory varies */
+	printf("line %d: %s\n", lineno, err);
+}
+
+static const sensors_subfeature *
+find_subfeature(const sensors_chip_name *chip, const char *name)
+{
+	const sensors_subfeature *sub;
+	const sensors_feature *feature;
+	int f = 0, s;
+
+	while ((feature = sensors_get_features(chip, &f))) {
+		s = 0;
+		while ((sub = sensors_get_all_subfeatures(chip, feature, &s)))
+			if (!strcmp(sub->name, name))
+				return sub;
+	}
+	return NULL;
+}
+
+static void read_subfeature(const sensors_chip_name *chip,
+			    const sensors_subfeature *sub)
+{
+	long long raw;
+	double value;
+	int err, exponent;
+
+	printf("%s %s:", chip->prefix, sub->name);
+	if ((err = sensors_get_value(chip, sub->number, &value)))
+		printf(" %s", sensors_strerror(err));
+	else
+		printf(" %.3f", value);
+	if ((err = sensors_get_value_raw(chip, sub->number, &raw, &exponent)))
+		printf(", raw: %s\n", sensors_strerror(err));
+	else
+		printf(", raw: %lldE%d\n", raw, exponent);
+}
+
+static void set_subfeature(const sensors_chip_name *chip,
+			   const sensors_subfeature *sub, double value)
+{
+	char path[4096], buf[64];
+	FILE *f;
+	int err;
+
+	printf("%s %s := %.3f:", chip->prefix, sub->name, value);
+	if ((err = sensors_set_value(chip, sub->number, value))) {
+		printf(" %s\n", sensors_strerror(err));
+		return;
+	}
+	snprintf(path, sizeof(path), "%s/%s", chip->path, sub->name);
+	if (!(f = fopen(path, "r")) || !fgets(buf, sizeof(buf), f)) {
+		printf(" can't read back %s\n", sub->name);
+		if (f)
+			fclose(f);
+		return;
+	}
+	fclose(f);
+	buf[strcspn(buf, "\n")] = '\0';
+	printf(" wrote %s\n", buf);
+}
+
+int main(int argc, char *argv[])
+{
+	sensors_chip_name match;
+	const sensors_chip_name *chip;
+	const sensors_subfeature *sub;
+	char *value;
+	FILE *config;
+	int i, nr, err;
+
+	if (argc < 2 || argc % 2) {
+		fprintf(stderr, "Usage: %s <config> "
+			"[<chip> <subfeature>[=<value>]]...\n", argv[0]);
+		return 1;
+	}
+
+	if (!(config = fopen(argv[1], "r"))) {
+		perror(argv[1]);
+		return 1;
+	}
+	sensors_parse_error_wfn = parse_error;
+	err = sensors_init(config);
+	fclose(config);
+	if (err) {
+		printf("sensors_init: %s\n", sensors_strerror(err));
+		return 0;
+	}
+
+	for (i = 2; i < argc; i += 2) {
+		if (sensors_parse_chip_name(argv[i], &match)) {
+			printf("%s: can't parse chip name\n", argv[i]);
+			continue;
+		}
+		nr = 0;
+		chip = sensors_get_detected_chips(&match, &nr);
+		sensors_free_chip_name(&match);
+		if (!chip) {
+			printf("%s: no such chip\n", argv[i]);
+			continue;
+		}
+
+		value = strchr(argv[i + 1], '=');
+		if (value)
+			*value++ = '\0';
+		if (!(sub = find_subfeature(chip, argv[i + 1]))) {
+			printf("%s: no such subfeature\n", argv[i + 1]);
+			continue;
+		}
+		if (value)
+			set_subfeature(chip, sub, atof(value));
+		else
+			read_subfeature(chip, sub);
+	}
+
+	sensors_cleanup();
+	return 0;
+}
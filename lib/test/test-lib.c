@@ -0,0 +1,662 @@
+/*
+    test-lib.c - Behavior tests of the libsensors API.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; version 2 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+/* Each test loads its own configuration, and runs on the tree generated
+   by test-lib.sh, with the known values it writes. Tests which change
+   the tree restore it. Runs the tests named on the command line, or all
+   of them. */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "../sensors.h"
+#include "../error.h"
+
+struct test {
+	const char *name;
+	const char *config;
+	void (*run)(void);
+};
+
+static int failed;
+
+#define CHECK(cond)	check((cond), #cond, __LINE__)
+
+static int check(int ok, const char *cond, int line)
+{
+	if (!ok) {
+		printf("  line %d: %s\n", line, cond);
+		failed = 1;
+	}
+	return ok;
+}
+
+/* Look up a detected chip by name, which must not contain wildcards */
+static const sensors_chip_name *get_chip(const char *name)
+{
+	sensors_chip_name match;
+	const sensors_chip_name *chip;
+	int nr = 0;
+
+	if (sensors_parse_chip_name(name, &match))
+		return NULL;
+	chip = sensors_get_detected_chips(&match, &nr);
+	sensors_free_chip_name(&match);
+	return chip;
+}
+
+static int get_subfeature_nr(const sensors_chip_name *chip, const char *name)
+{
+	const sensors_feature *feature;
+	const sensors_subfeature *sub;
+	int f = 0, s;
+
+	while ((feature = sensors_get_features(chip, &f))) {
+		s = 0;
+		while ((sub = sensors_get_all_subfeatures(chip, feature, &s)))
+			if (!strcmp(sub->name, name))
+				return sub->number;
+	}
+	return -1;
+}
+
+/* Read a subfeature by name */
+static int get_value(const char *chip_name, const char *name, double *value)
+{
+	const sensors_chip_name *chip = get_chip(chip_name);
+
+	if (!chip)
+		return -SENSORS_ERR_NO_ENTRY;
+	return sensors_get_value(chip, get_subfeature_nr(chip, name), value);
+}
+
+static void attr_path(const char *chip_name, const char *attr, char *path,
+		      size_t size)
+{
+	const sensors_chip_name *chip = get_chip(chip_name);
+
+	snprintf(path, size, "%s/%s", chip ? chip->path : "", attr);
+}
+
+/* Write to an attribute file of the tree, as the driver would update it */
+static void write_attr(const char *chip_name, const char *attr,
+		       const char *value)
+{
+	char path[4096];
+	FILE *f;
+
+	attr_path(chip_name, attr, path, sizeof(path));
+	unlink(path);	/* In case it was made unreadable */
+	if (!(f = fopen(path, "w"))) {
+		perror(path);
+		exit(1);
+	}
+	fprintf(f, "%s\n", value);
+	fclose(f);
+}
+
+/* Make an attribute file fail with EIO, as when the chip doesn't answer */
+static void break_attr(const char *chip_name, const char *attr)
+{
+	char path[4096];
+
+	attr_path(chip_name, attr, path, sizeof(path));
+	unlink(path);
+	if (symlink("/proc/self/mem", path)) {
+		perror(path);
+		exit(1);
+	}
+}
+
+/* Attributes which fail fast don't quarantine their chip */
+static void test_quarantine(void)
+{
+	const sensors_chip_name *chip = get_chip("it8728-isa-0290");
+	sensors_chip_health health;
+	double value;
+	int i;
+
+	break_attr("it8728-isa-0290", "in1_input");
+	for (i = 0; i < 5; i++)
+		CHECK(get_value("it8728-isa-0290", "in1_input", &value) ==
+		      -SENSORS_ERR_IO);
+	CHECK(get_value("it8728-isa-0290", "in0_input", &value) == 0 &&
+	      value == 1.2);
+	CHECK(sensors_get_chip_health(chip, &health) == 0 &&
+	      !health.quarantined && health.failures == 0);
+	write_attr("it8728-isa-0290", "in1_input", "1500");
+}
+
+/* Compute statements of a snapshot use the values of the same pass */
+static void test_snapshot(void)
+{
+	const sensors_chip_name *lm90 = get_chip("lm90-i2c-1-4c");
+	const sensors_chip_name *it87 = get_chip("it8728-isa-0290");
+	sensors_chip_name match;
+	sensors_snapshot *snapshot;
+	int temp1 = get_subfeature_nr(lm90, "temp1_input");
+	double value;
+
+	sensors_parse_chip_name("lm90-*", &match);
+	snapshot = sensors_snapshot_new(&match);
+	sensors_free_chip_name(&match);
+
+	CHECK(sensors_snapshot_get_value(snapshot, lm90, temp1, &value) ==
+	      -SENSORS_ERR_NO_ENTRY);	/* Not read yet */
+	CHECK(sensors_snapshot_read(snapshot) == 0);
+	CHECK(sensors_snapshot_get_value(snapshot, lm90, temp1, &value) == 0 &&
+	      value == 83.5);
+	CHECK(sensors_snapshot_get_value(snapshot, it87, 0, &value) ==
+	      -SENSORS_ERR_NO_ENTRY);	/* Not part of the snapshot */
+
+	/* Values only change on the next read */
+	write_attr("lm90-i2c-1-4c", "temp2_input", "40000");
+	CHECK(sensors_snapshot_get_value(snapshot, lm90, temp1, &value) == 0 &&
+	      value == 83.5);
+	CHECK(sensors_snapshot_read(snapshot) == 0);
+	CHECK(sensors_snapshot_get_value(snapshot, lm90, temp1, &value) == 0 &&
+	      value == 85);
+	CHECK(sensors_snapshot_get_value(snapshot, lm90,
+				get_subfeature_nr(lm90, "temp2_input"),
+				&value) == 0 && value == 40);
+
+	sensors_snapshot_free(snapshot);
+	write_attr("lm90-i2c-1-4c", "temp2_input", "38500");
+}
+
+/* Chips on different buses are read by different threads, and virtual
+   chips are evaluated from what they read. The values are the same as
+   when read one by one, on every pass. */
+static void test_snapshot_parallel(void)
+{
+	const sensors_chip_name *chip;
+	const sensors_feature *feature;
+	const sensors_subfeature *sub;
+	sensors_snapshot *snapshot;
+	double value, snap;
+	char buf[16];
+	int nr, f, s, pass, err;
+
+	snapshot = sensors_snapshot_new(NULL);
+	for (pass = 0; pass < 3; pass++) {
+		snprintf(buf, sizeof(buf), "%d", 40000 + pass * 20000);
+		write_attr("lm90-i2c-1-4c", "temp2_input", buf);
+		CHECK(sensors_snapshot_read(snapshot) == 0);
+
+		for (nr = 0; (chip = sensors_get_detected_chips(NULL, &nr));) {
+			f = 0;
+			while ((feature = sensors_get_features(chip, &f))) {
+				s = 0;
+				while ((sub = sensors_get_all_subfeatures(chip,
+							feature, &s))) {
+					err = sensors_get_value(chip,
+							sub->number, &value);
+					CHECK(sensors_snapshot_get_value(snapshot,
+						chip, sub->number, &snap) == err &&
+					      (err || snap == value));
+				}
+			}
+		}
+	}
+	CHECK(sensors_snapshot_get_value(snapshot, get_chip("hottest-virtual-0"),
+					 0, &value) == 0 && value == 80);
+
+	sensors_snapshot_free(snapshot);
+	write_attr("lm90-i2c-1-4c", "temp2_input", "38500");
+}
+
+/* All alarms are read at once, and the active ones found in the bitmap */
+static void test_alarms(void)
+{
+	const sensors_chip_name *name;
+	const sensors_feature *feature;
+	const sensors_subfeature *sub;
+	unsigned long *bitmap;
+	int nr = 0;
+
+	CHECK(sensors_get_alarm_count() > 0);
+	bitmap = calloc(SENSORS_ALARM_LONGS(sensors_get_alarm_count()),
+			sizeof(unsigned long));
+	if (!bitmap) {
+		perror("calloc");
+		exit(1);
+	}
+
+	CHECK(sensors_read_alarms(bitmap) == 0);
+	CHECK(!sensors_get_next_alarm(bitmap, &nr, &name, &feature));
+
+	write_attr("lm90-i2c-1-4c", "temp2_crit_alarm", "1");
+	CHECK(sensors_read_alarms(bitmap) == 1);
+	nr = 0;
+	sub = sensors_get_next_alarm(bitmap, &nr, &name, &feature);
+	CHECK(sub && !strcmp(sub->name, "temp2_crit_alarm") &&
+	      name == get_chip("lm90-i2c-1-4c") &&
+	      !strcmp(feature->name, "temp2"));
+	CHECK(!sensors_get_next_alarm(bitmap, &nr, &name, &feature));
+
+	free(bitmap);
+	write_attr("lm90-i2c-1-4c", "temp2_crit_alarm", "0");
+}
+
+#define SAMPLER_PERIOD	20
+#define SAMPLER_DEPTH	4
+
+/* Wait for the sampler to take samples after sample after, and read them.
+   Returns the number of samples read. */
+static int wait_samples(sensors_sample *samples, unsigned long long after)
+{
+	int i, n;
+
+	for (i = 0; i < 100; i++) {
+		n = sensors_sampler_read(samples, SAMPLER_DEPTH);
+		if (n == SAMPLER_DEPTH && samples[SAMPLER_DEPTH - 1].nr > after)
+			return n;
+		usleep(SAMPLER_PERIOD * 1000);
+	}
+	return n;
+}
+
+/* The sampler keeps the last samples, latest first */
+static void test_sampler(void)
+{
+	const sensors_chip_name *chip = get_chip("lm90-i2c-1-4c");
+	const sensors_metric *schema, *metric;
+	sensors_sample samples[SAMPLER_DEPTH];
+	int i, count, index;
+
+	schema = sensors_get_schema(&count);
+	metric = sensors_get_metric(chip, get_subfeature_nr(chip,
+							    "temp1_input"));
+	CHECK(schema && metric);
+	if (!schema || !metric)
+		return;
+	index = metric - schema;
+	for (i = 0; i < SAMPLER_DEPTH; i++) {
+		samples[i].value = malloc(count * sizeof(double));
+		samples[i].error = malloc(count * sizeof(int));
+		if (!samples[i].value || !samples[i].error) {
+			perror("malloc");
+			exit(1);
+		}
+	}
+
+	CHECK(sensors_sampler_read(samples, SAMPLER_DEPTH) < 0);
+	CHECK(sensors_sampler_start(NULL, SAMPLER_PERIOD, SAMPLER_DEPTH) == 0);
+	CHECK(wait_samples(samples, 0) == SAMPLER_DEPTH);
+	for (i = 0; i < SAMPLER_DEPTH; i++) {
+		CHECK(!samples[i].error[index] &&
+		      samples[i].value[index] == 45);
+		if (i)
+			CHECK(samples[i].nr == samples[i - 1].nr - 1 &&
+			      samples[i].stamp <= samples[i - 1].stamp);
+	}
+
+	/* Samples started after the change see the new value. The one
+	   after the latest may have been taken already. */
+	write_attr("lm90-i2c-1-4c", "temp1_input", "50000");
+	CHECK(wait_samples(samples, samples[0].nr + 1) == SAMPLER_DEPTH);
+	for (i = 0; i < SAMPLER_DEPTH; i++)
+		CHECK(!samples[i].error[index] &&
+		      samples[i].value[index] == 50);
+
+	sensors_sampler_stop();
+	CHECK(sensors_sampler_read(samples, SAMPLER_DEPTH) < 0);
+
+	for (i = 0; i < SAMPLER_DEPTH; i++) {
+		free(samples[i].value);
+		free(samples[i].error);
+	}
+	write_attr("lm90-i2c-1-4c", "temp1_input", "45000");
+}
+
+static void watch_called(const sensors_watch_event *event, void *data)
+{
+	*(sensors_watch_event *)data = *event;
+}
+
+/* Update the watches after setting the watched value */
+static int watch_update(const char *value)
+{
+	write_attr("lm90-i2c-1-4c", "temp1_input", value);
+	return sensors_watch_update();
+}
+
+/* A watch triggers after enough samples past its threshold, and clears
+   once the value gets back past the clear value */
+static void test_watch(void)
+{
+	const sensors_chip_name *chip = get_chip("lm90-i2c-1-4c");
+	const sensors_watch watch = { 0, 50, 47, 2 };
+	sensors_watch_event called, events[4];
+	struct pollfd pfd;
+	int id;
+
+	id = sensors_watch_add(chip, get_subfeature_nr(chip, "temp1_input"),
+			       &watch, watch_called, &called);
+	CHECK(id >= 0);
+	pfd.fd = sensors_get_watch_fd();
+	pfd.events = POLLIN;
+	CHECK(pfd.fd >= 0);
+
+	CHECK(watch_update("45000") == 0);
+	CHECK(watch_update("55000") == 0);	/* Once isn't enough */
+	CHECK(poll(&pfd, 1, 0) == 0);
+	CHECK(watch_update("56000") == 1);
+	CHECK(called.id == id && called.active && called.value == 56);
+	CHECK(poll(&pfd, 1, 0) == 1);
+	CHECK(sensors_read_watch_events(events, 4) == 1 &&
+	      events[0].id == id && events[0].active &&
+	      events[0].chip == chip &&
+	      !strcmp(events[0].subfeature->name, "temp1_input"));
+	CHECK(sensors_read_watch_events(events, 4) == 0);
+
+	CHECK(watch_update("48000") == 0);	/* Not past the clear value */
+	CHECK(watch_update("46000") == 1);
+	CHECK(called.id == id && !called.active && called.value == 46);
+	CHECK(sensors_read_watch_events(events, 4) == 1 &&
+	      !events[0].active);
+
+	CHECK(sensors_watch_remove(id) == 0);
+	CHECK(sensors_watch_remove(id) < 0);
+	CHECK(watch_update("60000") == 0);
+	CHECK(watch_update("60000") == 0);
+
+	write_attr("lm90-i2c-1-4c", "temp1_input", "45000");
+}
+
+/* Rolling statistics account for the values read from the chips, not for
+   those served from the cache or read as variables (temp2_input here) */
+static void test_rolling(void)
+{
+	const sensors_chip_name *chip = get_chip("lm90-i2c-1-4c");
+	int temp1 = get_subfeature_nr(chip, "temp1_input");
+	int temp2 = get_subfeature_nr(chip, "temp2_input");
+	static const char *const values[] = { "40000", "60000", "50000" };
+	sensors_rolling rolling;
+	double value;
+	int i;
+
+	CHECK(sensors_rolling_get(chip, temp1, &rolling) < 0);
+	CHECK(sensors_rolling_enable(chip, 10000) == 0);
+	CHECK(sensors_rolling_get(chip, temp1, &rolling) < 0);	/* No value */
+
+	for (i = 0; i < 3; i++) {
+		write_attr("lm90-i2c-1-4c", "temp1_input", values[i]);
+		CHECK(get_value("lm90-i2c-1-4c", "temp1_input", &value) == 0);
+		usleep(10000);
+	}
+	CHECK(sensors_rolling_get(chip, temp1, &rolling) == 0 &&
+	      rolling.count == 3 && rolling.min == 78.5 &&
+	      rolling.max == 98.5 && rolling.mean > 78.5 &&
+	      rolling.mean < 98.5 && rolling.stddev > 0);
+	CHECK(sensors_rolling_get(chip, temp2, &rolling) < 0);
+
+	CHECK(sensors_set_cache_max_age(chip, 10000) == 0);
+	CHECK(get_value("lm90-i2c-1-4c", "temp1_input", &value) == 0);
+	CHECK(sensors_set_cache_max_age(chip, 0) == 0);
+	CHECK(sensors_rolling_get(chip, temp1, &rolling) == 0 &&
+	      rolling.count == 3);
+
+	/* Nothing read for a whole window */
+	CHECK(sensors_rolling_enable(chip, 50) == 0);
+	usleep(60000);
+	CHECK(get_value("lm90-i2c-1-4c", "temp1_input", &value) == 0);
+	CHECK(sensors_rolling_get(chip, temp1, &rolling) == 0 &&
+	      rolling.count == 1 && rolling.min == 88.5 &&
+	      rolling.max == 88.5);
+
+	/* Other chips are not accounted for */
+	CHECK(get_value("it8728-isa-0290", "in0_input", &value) == 0);
+	CHECK(sensors_rolling_get(get_chip("it8728-isa-0290"), 0,
+				  &rolling) < 0);
+
+	CHECK(sensors_rolling_enable(chip, 0) == 0);
+	CHECK(sensors_rolling_get(chip, temp1, &rolling) < 0);
+
+	write_attr("lm90-i2c-1-4c", "temp1_input", "45000");
+}
+
+/* Read statistics count the reads from sysfs, failed or not */
+static void test_stats(void)
+{
+	const sensors_chip_name *chip = get_chip("it8728-isa-0290");
+	int in0 = get_subfeature_nr(chip, "in0_input");
+	int in1 = get_subfeature_nr(chip, "in1_input");
+	unsigned long long histogram;
+	sensors_stats stats;
+	double value;
+	int i;
+
+	CHECK(sensors_get_stats(chip, -1, &stats) < 0);
+	CHECK(sensors_stats_enable(chip, 1) == 0);
+	CHECK(sensors_get_stats(chip, -1, &stats) == 0 && stats.reads == 0);
+
+	CHECK(get_value("it8728-isa-0290", "in0_input", &value) == 0);
+	CHECK(get_value("it8728-isa-0290", "in0_input", &value) == 0);
+	break_attr("it8728-isa-0290", "in1_input");
+	CHECK(get_value("it8728-isa-0290", "in1_input", &value) < 0);
+	write_attr("it8728-isa-0290", "in1_input", "1500");
+
+	/* Values served from the cache are not counted */
+	CHECK(sensors_set_cache_max_age(chip, 10000) == 0);
+	CHECK(get_value("it8728-isa-0290", "in0_input", &value) == 0);
+	CHECK(sensors_set_cache_max_age(chip, 0) == 0);
+
+	CHECK(sensors_get_stats(chip, in0, &stats) == 0 &&
+	      stats.reads == 2 && stats.errors == 0);
+	CHECK(sensors_get_stats(chip, in1, &stats) == 0 &&
+	      stats.reads == 1 && stats.errors == 1);
+	CHECK(sensors_get_stats(chip, -1, &stats) == 0 &&
+	      stats.reads == 3 && stats.errors == 1 &&
+	      stats.max_ns > 0 && stats.total_ns >= stats.max_ns);
+	for (histogram = 0, i = 0; i < SENSORS_STATS_BUCKETS; i++)
+		histogram += stats.histogram[i];
+	CHECK(histogram == 3);
+
+	CHECK(sensors_reset_stats(chip) == 0);
+	CHECK(sensors_get_stats(chip, -1, &stats) == 0 && stats.reads == 0);
+
+	CHECK(sensors_stats_enable(chip, 0) == 0);
+	CHECK(sensors_get_stats(chip, -1, &stats) < 0);
+	CHECK(sensors_reset_stats(chip) < 0);
+}
+
+/* Compute count values of a subfeature at once, and one at a time through
+   the attribute file. Polynomials are evaluated in another order, which
+   may change the last bits. */
+#define ARRAY_COUNT	603	/* A few blocks, and a partial vector */
+
+static void check_array(const char *chip_name, const char *attr, int exact)
+{
+	const sensors_chip_name *chip = get_chip(chip_name);
+	int nr = get_subfeature_nr(chip, attr);
+	double raw[ARRAY_COUNT], value[ARRAY_COUNT], expected;
+	char milli[16];
+	int i, wrong = 0;
+
+	for (i = 0; i < ARRAY_COUNT; i++)
+		raw[i] = (i * 137 - 20000) / 1000.0;
+	CHECK(sensors_compute_array(chip, nr, raw, value, ARRAY_COUNT) == 0);
+	for (i = 0; i < ARRAY_COUNT; i++) {
+		snprintf(milli, sizeof(milli), "%d", i * 137 - 20000);
+		write_attr(chip_name, attr, milli);
+		if (get_value(chip_name, attr, &expected) ||
+		    (exact ? value[i] != expected :
+		     fabs(value[i] - expected) > 1e-12 * fabs(expected)))
+			wrong++;
+	}
+	CHECK(wrong == 0);
+
+	/* In place */
+	CHECK(sensors_compute_array(chip, nr, raw, raw, ARRAY_COUNT) == 0 &&
+	      !memcmp(raw, value, sizeof(raw)));
+}
+
+static void test_compute_array(void)
+{
+	const sensors_chip_name *chip = get_chip("lm90-i2c-1-4c");
+	int temp2 = get_subfeature_nr(chip, "temp2_input");
+	double raw[3] = { 1, 0, -1 };
+
+	check_array("lm90-i2c-1-4c", "temp1_input", 0);
+	write_attr("lm90-i2c-1-4c", "temp1_input", "45000");
+	check_array("lm90-i2c-1-4c", "temp2_input", 1);
+
+	CHECK(sensors_compute_array(chip, temp2, raw, raw, 3) ==
+	      -SENSORS_ERR_DIV_ZERO &&
+	      raw[0] > 0 && isnan(raw[1]) && raw[2] == -raw[0]);
+	CHECK(sensors_compute_array(chip, temp2, raw, raw, 0) == 0);
+	CHECK(sensors_compute_array(chip, temp2, raw, raw, -1) ==
+	      -SENSORS_ERR_NO_ENTRY);
+	write_attr("lm90-i2c-1-4c", "temp2_input", "38500");
+}
+
+/* Metric ids don't depend on I2C bus numbers, and the schema is built
+   once even if asked for by several threads at the same time */
+static unsigned long long fnv1a(const char *s)
+{
+	unsigned long long hash = 0xcbf29ce484222325ULL;
+
+	for (; *s; s++) {
+		hash ^= (unsigned char)*s;
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+struct schema_call {
+	const sensors_metric *schema;
+	int count;
+};
+
+static void *get_schema(void *data)
+{
+	struct schema_call *call = data;
+
+	call->schema = sensors_get_schema(&call->count);
+	return NULL;
+}
+
+static void test_schema(void)
+{
+	const sensors_chip_name *lm90 = get_chip("lm90-i2c-1-4c");
+	const sensors_chip_name *it87 = get_chip("it8728-isa-0290");
+	const sensors_metric *schema, *metric;
+	struct schema_call calls[4];
+	pthread_t threads[4];
+	char identity[256];
+	int i, j, duplicates = 0;
+
+	for (i = 0; i < 4; i++)
+		pthread_create(&threads[i], NULL, get_schema, &calls[i]);
+	for (i = 0; i < 4; i++)
+		pthread_join(threads[i], NULL);
+	schema = calls[0].schema;
+	for (i = 1; i < 4; i++)
+		CHECK(calls[i].schema == schema &&
+		      calls[i].count == calls[0].count);
+
+	for (i = 0; i < calls[0].count; i++)
+		for (j = i + 1; j < calls[0].count; j++)
+			if (schema[i].id == schema[j].id)
+				duplicates++;
+	CHECK(duplicates == 0);
+
+	metric = sensors_get_metric(lm90, get_subfeature_nr(lm90,
+							    "temp1_input"));
+	snprintf(identity, sizeof(identity), "lm90-i2c-%s-4c/temp1_input",
+		 sensors_get_adapter_name(&lm90->bus));
+	CHECK(metric && metric->id == fnv1a(identity) &&
+	      !strcmp(metric->chip_name, "lm90-i2c-1-4c"));
+	metric = sensors_get_metric(it87, get_subfeature_nr(it87,
+							    "in0_input"));
+	CHECK(metric && metric->id == fnv1a("it8728-isa-0290/in0_input"));
+}
+
+static const struct test tests[] = {
+	{ "quarantine", "chip \"it8728-*\"\n    option quarantine\n",
+	  test_quarantine },
+	{ "snapshot", "chip \"lm90-*\"\n"
+		      "    compute temp1 @+temp2_input, @-temp2_input\n",
+	  test_snapshot },
+	{ "snapshot-parallel", "virtual \"hottest\"\n"
+		"    aggregate temp1_input max \"temp*_input\" \"lm90-*\" "
+		"\"coretemp-*\"\n",
+	  test_snapshot_parallel },
+	{ "alarms", "# No configuration\n", test_alarms },
+	{ "sampler", "# No configuration\n", test_sampler },
+	{ "watch", "# No configuration\n", test_watch },
+	{ "rolling", "chip \"lm90-*\"\n"
+		     "    compute temp1 @+temp2_input, @-temp2_input\n",
+	  test_rolling },
+	{ "stats", "# No configuration\n", test_stats },
+	{ "compute-array", "chip \"lm90-*\"\n"
+		"    compute temp1 (@-32)/1.8, @*1.8+32\n"
+		"    compute temp2 temp1_input*10/@, temp1_input*10/@\n",
+	  test_compute_array },
+	{ "schema", "# No configuration\n", test_schema },
+	{ NULL }
+};
+
+static int run_test(const struct test *test)
+{
+	FILE *config;
+	char *buf;
+	int err;
+
+	failed = 0;
+	buf = strdup(test->config);
+	if (!buf || !(config = fmemopen(buf, strlen(buf), "r"))) {
+		perror("fmemopen");
+		exit(1);
+	}
+	err = sensors_init(config);
+	fclose(config);
+	free(buf);
+	if (err) {
+		printf("  sensors_init: %s\n", sensors_strerror(err));
+		failed = 1;
+	} else {
+		test->run();
+		sensors_cleanup();
+	}
+
+	printf("%s: %s\n", failed ? "FAILED" : "ok", test->name);
+	return failed;
+}
+
+int main(int argc, char *argv[])
+{
+	const struct test *test;
+	int i, status = 0;
+
+	for (test = tests; test->name; test++) {
+		for (i = 1; i < argc; i++)
+			if (!strcmp(argv[i], test->name))
+				break;
+		if (argc == 1 || i < argc)
+			status |= run_test(test);
+	}
+	return status;
+}
@@ -0,0 +1,71 @@
+#!/bin/bash
+#
+# test-lib.sh - regression tests of libsensors, on a generated tree
+#
+#    This program is free software; you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation; version 2 of the License.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with this program; if not, write to the Free Software
+#    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+#    MA 02110-1301 USA.
+#
+# The tests run on a generated tree of an it8728, a coretemp and an lm90.
+# Each compute-*.conf scenario is run by test-compute, with the arguments
+# listed on its "#@" lines, and its output is compared with
+# compute-*.conf.stdout. test-lib then runs the behavior tests of the API.
+
+TEST_DIR=$(dirname "$0")
+TEST_COMPUTE=$TEST_DIR/test-compute
+TEST_LIB=$TEST_DIR/test-lib
+GEN_HWMON_TREE=$TEST_DIR/../../prog/debug/gen-hwmon-tree
+
+TREE=$(mktemp -d) || exit 1
+trap 'rm -rf "$TREE"' EXIT
+"$GEN_HWMON_TREE" -c 3 -n 2 "$TREE" || exit 1
+
+# set_attr <hwmon nr> <attribute>=<value>...
+function set_attr() {
+	local HWMON=$TREE/class/hwmon/hwmon$1 ATTR
+	shift
+	for ATTR in "$@"; do
+		echo "${ATTR#*=}" > "$HWMON/${ATTR%%=*}"
+	done
+}
+
+# Known values, as the generated ones are random and sets change them
+function reset_tree() {
+	# it8728-isa-0290
+	set_attr 0 in0_input=1200 in0_min=200 in0_max=3300 \
+		in1_input=1500 in1_min=1000 in1_max=1800 \
+		temp1_input=45000 temp2_input=40000
+	# coretemp-isa-0000
+	set_attr 1 temp1_input=52000 temp2_input=48000 temp3_input=61000 \
+		temp1_crit=100000 temp2_crit=95000 temp3_crit=105000
+	# lm90-i2c-1-4c
+	set_attr 2 temp1_input=45000 temp2_input=38500 temp1_max=80000 \
+		temp1_crit=100000 temp2_crit=90000
+}
+
+FAILED=0
+for CONF in "$TEST_DIR"/compute-*.conf; do
+	reset_tree
+	OUTPUT=$(SENSORS_SYSFS_ROOT=$TREE "$TEST_COMPUTE" "$CONF" \
+		 $(sed -n 's/^#@//p' "$CONF"))
+	if diff -u "$CONF.stdout" - <<< "$OUTPUT"; then
+		echo "ok: ${CONF##*/}"
+	else
+		echo "FAILED: ${CONF##*/}"
+		FAILED=1
+	fi
+done
+
+reset_tree
+SENSORS_SYSFS_ROOT=$TREE "$TEST_LIB" || FAILED=1
+exit $FAILED
@@ -73,11 +73,27 @@ int main(void)
 			case COMPUTE:
 				printf("COMPUTE\n");
 				break;
+
+			case TABLE:
+				printf("TABLE\n");
+				break;
 	
 			case IGNORE:
 				printf("IGNORE\n");
 				break;
 	
+			case OPTION:
+				printf("OPTION\n");
+				break;
+
+			case VIRTUAL:
+				printf("VIRTUAL\n");
+				break;
+
+			case AGGREGATE:
+				printf("AGGREGATE\n");
+				break;
+	
 			case FLOAT:
 				printf("FLOAT: %f\n", sensors_yylval.value);
 				break;
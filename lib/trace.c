@@ -0,0 +1,356 @@
+/*
+    trace.c - Part of libsensors, a Linux library for reading sensor data.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+
+/* Traces of the accesses to attribute files. A trace file starts with a
+   header, followed by fixed size records. Each path is defined once, by
+   a record of kind 'P' with the length of the path, followed by the path
+   itself, before the first access to it. Paths are then referenced by
+   their index, in order of definition. Traces use the byte order of the
+   machine which recorded them. */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sensors.h"
+#include "error.h"
+#include "general.h"
+#include "trace.h"
+
+#define TRACE_MAGIC		"LMSTRACE"
+#define TRACE_VERSION		1
+#define TRACE_BYTE_ORDER	0x01020304
+#define TRACE_PATH		'P'
+
+/* Sleeping is too coarse for short delays, which are busy waits */
+#define TRACE_SPIN_NS		200000
+
+#define FNV_OFFSET_BASIS	0xcbf29ce484222325ULL
+#define FNV_PRIME		0x100000001b3ULL
+
+struct trace_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+};
+
+struct trace_record {
+	uint8_t kind;
+	uint8_t pad[3];
+	uint32_t path;		/* index of the path, or its length */
+	int32_t err;
+	uint32_t ns;		/* latency, saturated */
+	union sensors_trace_value value;
+};
+
+struct trace_path {
+	char *path;
+	struct trace_record *records;	/* when replaying */
+	int records_count;
+	int records_max;
+	int next;			/* next record to replay */
+};
+
+int sensors_trace_mode;
+
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static FILE *trace_file;		/* when recording */
+static struct trace_path *paths;
+static int paths_count;
+static int paths_max;
+static int *paths_table;		/* hash table of index + 1, 0 if free */
+static unsigned int paths_table_size;
+
+static unsigned int trace_hash(const char *path)
+{
+	unsigned long long hash = FNV_OFFSET_BASIS;
+
+	for (; *path; path++) {
+		hash ^= (unsigned char)*path;
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+/* Slot of a path in the hash table, free if the path isn't in it */
+static int *trace_slot(const char *path)
+{
+	unsigned int i;
+
+	for (i = trace_hash(path) & (paths_table_size - 1);
+	     paths_table[i] && strcmp(paths[paths_table[i] - 1].path, path);
+	     i = (i + 1) & (paths_table_size - 1))
+		;
+	return &paths_table[i];
+}
+
+/* Add a path, growing the hash table so that it is at most half full */
+static int trace_add_path(const char *path)
+{
+	struct trace_path entry;
+	unsigned int i;
+	int *slot;
+
+	if ((unsigned int)(paths_count + 1) * 2 > paths_table_size) {
+		free(paths_table);
+		paths_table_size = paths_table_size ? paths_table_size * 2 : 64;
+		paths_table = calloc(paths_table_size, sizeof(int));
+		if (!paths_table)
+			sensors_fatal_error(__func__, "Out of memory");
+		for (i = 0; i < (unsigned int)paths_count; i++)
+			*trace_slot(paths[i].path) = i + 1;
+	}
+
+	memset(&entry, 0, sizeof(entry));
+	if (!(entry.path = strdup(path)))
+		sensors_fatal_error(__func__, "Out of memory");
+	sensors_add_array_el(&entry, &paths, &paths_count, &paths_max,
+			     sizeof(struct trace_path));
+	slot = trace_slot(path);
+	*slot = paths_count;
+	return paths_count - 1;
+}
+
+static int trace_find_path(const char *path)
+{
+	return paths_table_size ? *trace_slot(path) - 1 : -1;
+}
+
+static void trace_free(void)
+{
+	int i;
+
+	for (i = 0; i < paths_count; i++) {
+		free(paths[i].path);
+		free(paths[i].records);
+	}
+	free(paths);
+	free(paths_table);
+	paths = NULL;
+	paths_table = NULL;
+	paths_count = paths_max = 0;
+	paths_table_size = 0;
+}
+
+static int trace_load(FILE *f)
+{
+	struct trace_header header;
+	struct trace_record record;
+	struct trace_path *entry;
+	char path[NAME_MAX];
+
+	if (fread(&header, sizeof(header), 1, f) != 1 ||
+	    memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) ||
+	    header.version != TRACE_VERSION ||
+	    header.byte_order != TRACE_BYTE_ORDER)
+		return -SENSORS_ERR_PARSE;
+
+	while (fread(&record, sizeof(record), 1, f) == 1) {
+		if (record.kind == TRACE_PATH) {
+			if (record.path >= sizeof(path) ||
+			    fread(path, record.path, 1, f) != 1)
+				return -SENSORS_ERR_PARSE;
+			path[record.path] = '\0';
+			trace_add_path(path);
+			continue;
+		}
+		if (record.path >= (uint32_t)paths_count)
+			return -SENSORS_ERR_PARSE;
+		entry = &paths[record.path];
+		sensors_add_array_el(&record, &entry->records,
+				     &entry->records_count, &entry->records_max,
+				     sizeof(struct trace_record));
+	}
+	return ferror(f) ? -SENSORS_ERR_PARSE : 0;
+}
+
+int sensors_trace_start(const char *path, int flags)
+{
+	struct trace_header header;
+	FILE *f;
+	int err = 0;
+
+	sensors_trace_stop();
+	if (!(flags & SENSORS_TRACE_RECORD) == !(flags & SENSORS_TRACE_REPLAY))
+		return -SENSORS_ERR_NO_ENTRY;
+
+	pthread_mutex_lock(&trace_lock);
+	if (flags & SENSORS_TRACE_RECORD) {
+		if (!(f = fopen(path, "we"))) {
+			err = -SENSORS_ERR_KERNEL;
+			goto exit_unlock;
+		}
+		memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+		header.version = TRACE_VERSION;
+		header.byte_order = TRACE_BYTE_ORDER;
+		if (fwrite(&header, sizeof(header), 1, f) != 1) {
+			fclose(f);
+			err = -SENSORS_ERR_KERNEL;
+			goto exit_unlock;
+		}
+		trace_file = f;
+	} else {
+		if (!(f = fopen(path, "re"))) {
+			err = -SENSORS_ERR_KERNEL;
+			goto exit_unlock;
+		}
+		err = trace_load(f);
+		fclose(f);
+		if (err) {
+			trace_free();
+			goto exit_unlock;
+		}
+	}
+	sensors_trace_mode = flags;
+
+exit_unlock:
+	pthread_mutex_unlock(&trace_lock);
+	return err;
+}
+
+void sensors_trace_stop(void)
+{
+	pthread_mutex_lock(&trace_lock);
+	sensors_trace_mode = 0;
+	if (trace_file) {
+		fclose(trace_file);
+		trace_file = NULL;
+	}
+	trace_free();
+	pthread_mutex_unlock(&trace_lock);
+}
+
+int sensors_trace_env(void)
+{
+	const char *path;
+	int flags;
+
+	if (sensors_trace_mode)
+		return 0;
+
+	if ((path = secure_getenv("SENSORS_TRACE_RECORD")) && *path) {
+		flags = SENSORS_TRACE_RECORD;
+	} else if ((path = secure_getenv("SENSORS_TRACE_REPLAY")) && *path) {
+		flags = SENSORS_TRACE_REPLAY;
+		if (secure_getenv("SENSORS_TRACE_NO_DELAY"))
+			flags |= SENSORS_TRACE_NO_DELAY;
+	} else {
+		return 0;
+	}
+	return sensors_trace_start(path, flags);
+}
+
+void sensors_trace_record(const char *path, int kind, int err, long long ns,
+			  const union sensors_trace_value *value)
+{
+	struct trace_record record;
+	int nr;
+
+	memset(&record, 0, sizeof(record));
+	pthread_mutex_lock(&trace_lock);
+	if (!trace_file)
+		goto exit_unlock;
+
+	if ((nr = trace_find_path(path)) < 0) {
+		nr = trace_add_path(path);
+		record.kind = TRACE_PATH;
+		record.path = strlen(path);
+		fwrite(&record, sizeof(record), 1, trace_file);
+		fwrite(path, record.path, 1, trace_file);
+	}
+
+	record.kind = kind;
+	record.path = nr;
+	record.err = err;
+	record.ns = ns > UINT32_MAX ? UINT32_MAX : ns;
+	if (!err)
+		record.value = *value;
+	fwrite(&record, sizeof(record), 1, trace_file);
+
+exit_unlock:
+	pthread_mutex_unlock(&trace_lock);
+}
+
+static void trace_delay(long long ns)
+{
+	long long deadline = sensors_get_time_ns() + ns;
+	struct timespec delay;
+
+	if (ns > TRACE_SPIN_NS) {
+		ns -= TRACE_SPIN_NS;
+		delay.tv_sec = ns / 1000000000;
+		delay.tv_nsec = ns % 1000000000;
+		nanosleep(&delay, NULL);
+	}
+	while (sensors_get_time_ns() < deadline)
+		;
+}
+
+int sensors_trace_replay(const char *path, int kind,
+			 union sensors_trace_value *value)
+{
+	struct trace_path *entry;
+	struct trace_record *record = NULL;
+	long long ns;
+	int i, nr, err;
+
+	pthread_mutex_lock(&trace_lock);
+	if ((nr = trace_find_path(path)) >= 0) {
+		/* Accesses are replayed in a loop */
+		entry = &paths[nr];
+		for (i = 0; i < entry->records_count; i++) {
+			record = &entry->records[(entry->next + i) %
+						 entry->records_count];
+			if (record->kind == kind)
+				break;
+		}
+		if (i < entry->records_count)
+			entry->next = (entry->next + i + 1) %
+				      entry->records_count;
+		else
+			record = NULL;
+	}
+	if (!record) {
+		pthread_mutex_unlock(&trace_lock);
+		/* Writes which weren't recorded are ignored */
+		return kind == TRACE_WRITE ? 0 : -SENSORS_ERR_KERNEL;
+	}
+	err = record->err;
+	if (!err && kind != TRACE_WRITE)
+		*value = record->value;
+	ns = record->ns;
+	pthread_mutex_unlock(&trace_lock);
+
+	if (!(sensors_trace_mode & SENSORS_TRACE_NO_DELAY))
+		trace_delay(ns);
+	return err;
+}
+
+void sensors_trace_flush(void)
+{
+	pthread_mutex_lock(&trace_lock);
+	if (trace_file)
+		fflush(trace_file);
+	pthread_mutex_unlock(&trace_lock);
+}
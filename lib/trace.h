@@ -0,0 +1,54 @@
+/*
+    trace.h - Part of libsensors, a Linux library for reading sensor data.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+
+#ifndef LIB_SENSORS_TRACE_H
+#define LIB_SENSORS_TRACE_H
+
+/* Kinds of attribute accesses */
+#define TRACE_READ	'R'	/* value read as a double, scaled */
+#define TRACE_READ_RAW	'I'	/* value read as an integer */
+#define TRACE_WRITE	'W'	/* value written, not scaled */
+
+union sensors_trace_value {
+	double d;
+	long long i;
+};
+
+/* Flags of the active trace, 0 if there is none */
+extern int sensors_trace_mode;
+
+/* Start the trace set in the environment, unless one is active already.
+   Returns 0 on success, <0 on error. */
+int sensors_trace_env(void);
+
+/* Record an access to an attribute file, path being relative to the
+   sysfs root, which took ns nanoseconds and returned err */
+void sensors_trace_record(const char *path, int kind, int err, long long ns,
+			  const union sensors_trace_value *value);
+
+/* Replay the next access of this kind to an attribute file, and return
+   the error it returned. Files which were never read can't be read. */
+int sensors_trace_replay(const char *path, int kind,
+			 union sensors_trace_value *value);
+
+/* Write what was recorded so far to the trace file */
+void sensors_trace_flush(void);
+
+#endif /* def LIB_SENSORS_TRACE_H */
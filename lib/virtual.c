@@ -0,0 +1,305 @@
+/*
+    virtual.c - Part of libsensors, a Linux library for reading sensor data.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+
+/* Virtual chips are defined by the configuration file. Each subfeature of
+   a virtual chip aggregates the matching subfeatures of the detected
+   chips, so that applications can read a single value instead of scanning
+   all of them. Virtual chips are not read from sysfs, and don't have
+   health of their own. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <fnmatch.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "access.h"
+#include "general.h"
+#include "sysfs.h"
+#include "virtual.h"
+
+/* A subfeature of a virtual chip, before sorting */
+struct virtual_subfeature {
+	sensors_subfeature_type type;
+	int nr;
+	const sensors_aggregate *aggregate;
+};
+
+/* Subfeatures are sorted the way they are for detected chips: by feature
+   type, channel number, then subfeature type */
+static int virtual_subfeature_cmp(const void *p1, const void *p2)
+{
+	const struct virtual_subfeature *sf1 = p1, *sf2 = p2;
+
+	if ((sf1->type >> 8) != (sf2->type >> 8))
+		return (sf1->type >> 8) - (sf2->type >> 8);
+	if (sf1->nr != sf2->nr)
+		return sf1->nr - sf2->nr;
+	return sf1->type - sf2->type;
+}
+
+/* Build the features and subfeatures of a virtual chip from its aggregate
+   statements. Returns the number of subfeatures. */
+static int virtual_read_features(sensors_chip_features *entry,
+				 const sensors_virtual *virtual)
+{
+	struct virtual_subfeature *sf;
+	const sensors_aggregate *aggregate;
+	sensors_subfeature *subfeature;
+	int i, j, sfnum = 0, fnum = 0;
+
+	sf = malloc((virtual->aggregates_count + 1) * sizeof(*sf));
+	if (!sf)
+		sensors_fatal_error(__func__, "Out of memory");
+
+	for (i = 0; i < virtual->aggregates_count; i++) {
+		aggregate = &virtual->aggregates[i];
+		sf[sfnum].type = sensors_subfeature_get_type(aggregate->name,
+							     &sf[sfnum].nr);
+		if (sf[sfnum].type == SENSORS_SUBFEATURE_UNKNOWN) {
+			sensors_parse_error_wfn("Unknown aggregate subfeature",
+						aggregate->line.filename,
+						aggregate->line.lineno);
+			continue;
+		}
+		for (j = 0; j < sfnum; j++)
+			if (!strcmp(sf[j].aggregate->name, aggregate->name))
+				break;
+		if (j < sfnum) {
+			sensors_parse_error_wfn("Duplicate aggregate subfeature",
+						aggregate->line.filename,
+						aggregate->line.lineno);
+			continue;
+		}
+		sf[sfnum++].aggregate = aggregate;
+	}
+	qsort(sf, sfnum, sizeof(*sf), virtual_subfeature_cmp);
+
+	entry->subfeature = calloc(sfnum + 1, sizeof(sensors_subfeature));
+	entry->feature = calloc(sfnum + 1, sizeof(sensors_feature));
+	entry->sources = calloc(sfnum + 1, sizeof(sensors_aggregate_sources));
+	if (!entry->subfeature || !entry->feature || !entry->sources)
+		sensors_fatal_error(__func__, "Out of memory");
+
+	for (i = 0; i < sfnum; i++) {
+		/* New main feature? */
+		if (!i || (sf[i].type >> 8) != (sf[i - 1].type >> 8) ||
+		    sf[i].nr != sf[i - 1].nr) {
+			entry->feature[fnum].name =
+				sensors_get_feature_name(sf[i].type >> 8,
+							 sf[i].aggregate->name);
+			entry->feature[fnum].number = fnum;
+			entry->feature[fnum].first_subfeature = i;
+			entry->feature[fnum].type = sf[i].type >> 8;
+			fnum++;
+		}
+
+		subfeature = &entry->subfeature[i];
+		subfeature->name = strdup(sf[i].aggregate->name);
+		if (!subfeature->name)
+			sensors_fatal_error(__func__, "Out of memory");
+		subfeature->number = i;
+		subfeature->type = sf[i].type;
+		subfeature->mapping = fnum - 1;
+		subfeature->flags = SENSORS_MODE_R;
+		entry->sources[i].aggregate = sf[i].aggregate;
+	}
+	entry->subfeature_count = sfnum;
+	entry->feature_count = fnum;
+
+	free(sf);
+	return sfnum;
+}
+
+static void sensors_add_virtual_chip(const sensors_virtual *virtual)
+{
+	sensors_chip_features entry;
+
+	memset(&entry, 0, sizeof(entry));
+	entry.chip.prefix = strdup(virtual->name);
+	if (!entry.chip.prefix)
+		sensors_fatal_error(__func__, "Out of memory");
+	entry.chip.bus.type = SENSORS_BUS_TYPE_VIRTUAL;
+	entry.chip.bus.nr = 0;
+	entry.chip.addr = 0;
+	entry.chip.path = NULL;
+
+	if (sensors_lookup_chip(&entry.chip)) {
+		sensors_parse_error_wfn("Duplicate chip name",
+					virtual->line.filename,
+					virtual->line.lineno);
+		free(entry.chip.prefix);
+		return;
+	}
+
+	if (!virtual_read_features(&entry, virtual)) {
+		free(entry.chip.prefix);
+		free(entry.subfeature);
+		free(entry.feature);
+		free(entry.sources);
+		return;
+	}
+
+	entry.i2c_root = -1;
+	entry.update_interval = -1;
+	entry.cache = calloc(entry.subfeature_count,
+			     sizeof(sensors_cache_entry));
+	entry.state = sensors_new_chip_state();
+	if (!entry.cache)
+		sensors_fatal_error(__func__, "Out of memory");
+
+	sensors_add_proc_chips(&entry);
+}
+
+/* Check whether a subfeature of a detected chip is a source of an
+   aggregate */
+static int aggregate_match(const sensors_aggregate *aggregate,
+			   const sensors_chip_features *chip_features,
+			   const sensors_subfeature *subfeature)
+{
+	int i;
+
+	if (!(subfeature->flags & SENSORS_MODE_R) ||
+	    fnmatch(aggregate->pattern, subfeature->name, 0))
+		return 0;
+	for (i = 0; i < aggregate->chips.fits_count; i++)
+		if (sensors_match_chip(&chip_features->chip,
+				       &aggregate->chips.fits[i]))
+			return 1;
+	return 0;
+}
+
+/* Find the sources of an aggregate. Returns their number, and records them
+   if chip and subfeature aren't NULL. */
+static int aggregate_sources(const sensors_aggregate *aggregate, int *chip,
+			     int *subfeature)
+{
+	const sensors_chip_features *chip_features;
+	int i, j, n = 0;
+
+	for (i = 0; i < sensors_proc_chips_count; i++) {
+		chip_features = &sensors_proc_chips[i];
+		/* Virtual chips can't be sources */
+		if (chip_features->sources)
+			continue;
+		for (j = 0; j < chip_features->subfeature_count; j++) {
+			if (!aggregate_match(aggregate, chip_features,
+					     &chip_features->subfeature[j]))
+				continue;
+			if (chip) {
+				chip[n] = i;
+				subfeature[n] = j;
+			}
+			n++;
+		}
+	}
+	return n;
+}
+
+static void sensors_bind_sources(sensors_aggregate_sources *sources)
+{
+	sources->count = aggregate_sources(sources->aggregate, NULL, NULL);
+	sources->chip = malloc((sources->count + 1) * sizeof(int));
+	sources->subfeature = malloc((sources->count + 1) * sizeof(int));
+	if (!sources->chip || !sources->subfeature)
+		sensors_fatal_error(__func__, "Out of memory");
+	aggregate_sources(sources->aggregate, sources->chip,
+			  sources->subfeature);
+}
+
+void sensors_bind_virtuals(void)
+{
+	sensors_chip_features *chip_features;
+	int i, j;
+
+	for (i = 0; i < sensors_config_virtuals_count; i++)
+		sensors_add_virtual_chip(&sensors_config_virtuals[i]);
+
+	for (i = 0; i < sensors_proc_chips_count; i++) {
+		chip_features = &sensors_proc_chips[i];
+		if (!chip_features->sources)
+			continue;
+		for (j = 0; j < chip_features->subfeature_count; j++)
+			sensors_bind_sources(&chip_features->sources[j]);
+	}
+}
+
+static int virtual_read_source(const sensors_chip_features *chip_features,
+			       const sensors_subfeature *subfeature,
+			       void *data, double *value)
+{
+	(void)data; /* hide warning */
+
+	return sensors_compute_source(chip_features, subfeature, MAX_AGE_CHIP,
+				      value);
+}
+
+int sensors_eval_aggregate(const sensors_chip_features *chip_features,
+			   int subfeat_nr, sensors_source_fn get, void *data,
+			   double *value)
+{
+	const sensors_aggregate_sources *sources;
+	const sensors_chip_features *chip;
+	double val, result = 0;
+	int i, res, count = 0, stale = 0;
+	int err = -SENSORS_ERR_NO_ENTRY;
+
+	if (!get)
+		get = virtual_read_source;
+
+	sources = &chip_features->sources[subfeat_nr];
+	for (i = 0; i < sources->count; i++) {
+		chip = &sensors_proc_chips[sources->chip[i]];
+		res = get(chip, &chip->subfeature[sources->subfeature[i]],
+			  data, &val);
+		if (res == -SENSORS_ERR_STALE) {
+			stale = res;
+		} else if (res) {
+			err = res;
+			continue;
+		}
+
+		if (!count++) {
+			result = val;
+			continue;
+		}
+		switch (sources->aggregate->function) {
+		case SENSORS_AGGREGATE_MAX:
+			if (val > result)
+				result = val;
+			break;
+		case SENSORS_AGGREGATE_MIN:
+			if (val < result)
+				result = val;
+			break;
+		case SENSORS_AGGREGATE_SUM:
+		case SENSORS_AGGREGATE_AVG:
+			result += val;
+			break;
+		}
+	}
+
+	if (!count)
+		return err;
+	if (sources->aggregate->function == SENSORS_AGGREGATE_AVG)
+		result /= count;
+	*value = result;
+	return stale;
+}
@@ -0,0 +1,44 @@
+/*
+    virtual.h - Part of libsensors, a Linux library for reading sensor data.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+
+#ifndef LIB_SENSORS_VIRTUAL_H
+#define LIB_SENSORS_VIRTUAL_H
+
+#include "data.h"
+
+/* Get the value of a source subfeature of an aggregate. Returns 0 or
+   -SENSORS_ERR_STALE if value is set, another error otherwise. */
+typedef int (*sensors_source_fn)(const sensors_chip_features *chip_features,
+				 const sensors_subfeature *subfeature,
+				 void *data, double *value);
+
+/* Add the virtual chips of the configuration to the detected chips, and
+   find the subfeatures their aggregates are computed from */
+void sensors_bind_virtuals(void);
+
+/* Compute the value of a subfeature of a virtual chip. Sources which
+   can't be read are left out. Sources are read from their chips if get
+   is NULL. Returns 0 on success, -SENSORS_ERR_STALE if some sources are
+   stale, another error if no source could be read. */
+int sensors_eval_aggregate(const sensors_chip_features *chip_features,
+			   int subfeat_nr, sensors_source_fn get, void *data,
+			   double *value);
+
+#endif /* def LIB_SENSORS_VIRTUAL_H */
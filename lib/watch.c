@@ -0,0 +1,419 @@
+/*
+    watch.c - Part of libsensors, a Linux library for reading sensor data.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+/* Software thresholds. Each watch compares the values of a subfeature to
+   a threshold, and reports a transition when the values stayed past the
+   threshold for a number of samples, and again when they got back past
+   the clear value. Watches are evaluated by sensors_watch_update(), and
+   by the sampler thread after each sample, so all the state is protected
+   by a mutex. Chips are read and callbacks are called without holding
+   it, so that a slow chip or callback doesn't hold up the sampler. */
+
+#include <sys/eventfd.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "access.h"
+#include "general.h"
+#include "watch.h"
+
+#define WATCH_QUEUE_MAX	256
+
+typedef struct sensors_watch_entry {
+	int id;
+	const sensors_chip_features *chip;
+	const sensors_subfeature *subfeature;
+	int flat;		/* index of the subfeature in a sample */
+	sensors_watch watch;
+	sensors_watch_fn fn;
+	void *data;
+	int active;
+	int samples;		/* consecutive samples past the threshold */
+} sensors_watch_entry;
+
+/* A value read from the chips for a watch by sensors_watch_update() */
+typedef struct sensors_watch_read {
+	int id;
+	const sensors_chip_features *chip;
+	const sensors_subfeature *subfeature;
+	double value;
+	int error;
+} sensors_watch_read;
+
+/* A transition, with the callback to call */
+typedef struct sensors_watch_call {
+	sensors_watch_event event;
+	sensors_watch_fn fn;
+	void *data;
+} sensors_watch_call;
+
+static pthread_mutex_t watch_lock = PTHREAD_MUTEX_INITIALIZER;
+static sensors_watch_entry *watches;
+static int watches_count;
+static int watches_max;
+static int watch_next_id;
+
+/* Events waiting for sensors_read_watch_events(), oldest first */
+static sensors_watch_event watch_queue[WATCH_QUEUE_MAX];
+static int watch_queue_first;
+static int watch_queue_count;
+static int watch_fd = -1;
+
+#define watches_add(el) sensors_add_array_el( \
+	(el), &watches, &watches_count, &watches_max, \
+	sizeof(sensors_watch_entry))
+
+static int sensors_watch_add_entry(const sensors_chip_features *chip,
+				   const sensors_subfeature *subfeature,
+				   const sensors_watch *watch,
+				   sensors_watch_fn fn, void *data)
+{
+	sensors_watch_entry entry;
+	int i;
+
+	entry.chip = chip;
+	entry.subfeature = subfeature;
+	entry.flat = subfeature->number;
+	for (i = 0; &sensors_proc_chips[i] != chip; i++)
+		entry.flat += sensors_proc_chips[i].subfeature_count;
+	entry.watch = *watch;
+	if (entry.watch.count < 1)
+		entry.watch.count = 1;
+	entry.fn = fn;
+	entry.data = data;
+	entry.active = 0;
+	entry.samples = 0;
+
+	pthread_mutex_lock(&watch_lock);
+	entry.id = watch_next_id++;
+	watches_add(&entry);
+	pthread_mutex_unlock(&watch_lock);
+
+	return entry.id;
+}
+
+int sensors_watch_add(const sensors_chip_name *name, int subfeat_nr,
+		      const sensors_watch *watch, sensors_watch_fn fn,
+		      void *data)
+{
+	const sensors_chip_features *chip;
+
+	if (sensors_chip_name_has_wildcards(name))
+		return -SENSORS_ERR_WILDCARDS;
+	if (!(chip = sensors_lookup_chip(name)) ||
+	    subfeat_nr < 0 || subfeat_nr >= chip->subfeature_count)
+		return -SENSORS_ERR_NO_ENTRY;
+	if (!(chip->subfeature[subfeat_nr].flags & SENSORS_MODE_R))
+		return -SENSORS_ERR_ACCESS_R;
+
+	return sensors_watch_add_entry(chip, &chip->subfeature[subfeat_nr],
+				       watch, fn, data);
+}
+
+static int has_suffix(const char *name, const char *suffix)
+{
+	size_t len = strlen(name), slen = strlen(suffix);
+
+	return len >= slen && !strcmp(name + len - slen, suffix);
+}
+
+int sensors_watch_add_limits(const sensors_chip_name *name,
+			     const sensors_feature *feature,
+			     sensors_watch_fn fn, void *data)
+{
+	const sensors_chip_features *chip;
+	const sensors_subfeature *input = NULL, *limit, *hyst;
+	sensors_watch watch;
+	char hyst_name[NAME_MAX];
+	int i, res, count = 0;
+
+	if (sensors_chip_name_has_wildcards(name))
+		return -SENSORS_ERR_WILDCARDS;
+	if (!(chip = sensors_lookup_chip(name)))
+		return -SENSORS_ERR_NO_ENTRY;
+
+	for (i = feature->first_subfeature; i < chip->subfeature_count &&
+	     chip->subfeature[i].mapping == feature->number; i++) {
+		if (has_suffix(chip->subfeature[i].name, "_input")) {
+			input = &chip->subfeature[i];
+			break;
+		}
+		/* Power meters may only have an average */
+		if (!input && has_suffix(chip->subfeature[i].name, "_average"))
+			input = &chip->subfeature[i];
+	}
+	if (!input || !(input->flags & SENSORS_MODE_R))
+		return -SENSORS_ERR_NO_ENTRY;
+
+	for (i = feature->first_subfeature; i < chip->subfeature_count &&
+	     chip->subfeature[i].mapping == feature->number; i++) {
+		limit = &chip->subfeature[i];
+		if (has_suffix(limit->name, "_min") ||
+		    has_suffix(limit->name, "_lcrit"))
+			watch.below = 1;
+		else if (has_suffix(limit->name, "_max") ||
+			 has_suffix(limit->name, "_crit") ||
+			 has_suffix(limit->name, "_emergency"))
+			watch.below = 0;
+		else
+			continue;
+		if (sensors_get_value(name, limit->number, &watch.threshold))
+			continue;
+
+		/* Use the hysteresis of the chip, if there is one */
+		watch.clear = watch.threshold;
+		snprintf(hyst_name, sizeof(hyst_name), "%s_hyst", limit->name);
+		for (hyst = chip->subfeature + feature->first_subfeature;
+		     hyst < chip->subfeature + chip->subfeature_count &&
+		     hyst->mapping == feature->number; hyst++) {
+			if (!strcmp(hyst->name, hyst_name)) {
+				sensors_get_value(name, hyst->number,
+						  &watch.clear);
+				break;
+			}
+		}
+		watch.count = 1;
+
+		res = sensors_watch_add_entry(chip, input, &watch, fn, data);
+		if (res < 0)
+			return res;
+		count++;
+	}
+
+	return count;
+}
+
+int sensors_watch_remove(int id)
+{
+	int i, err = -SENSORS_ERR_NO_ENTRY;
+
+	pthread_mutex_lock(&watch_lock);
+	for (i = 0; i < watches_count; i++) {
+		if (watches[i].id == id) {
+			memmove(&watches[i], &watches[i + 1],
+				(watches_count - i - 1) *
+				sizeof(sensors_watch_entry));
+			watches_count--;
+			err = 0;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&watch_lock);
+
+	return err;
+}
+
+/* Feed a value to a watch. Returns 1 on a transition, 0 otherwise. */
+static int watch_feed(sensors_watch_entry *entry, double value)
+{
+	const sensors_watch *watch = &entry->watch;
+
+	if (!entry->active) {
+		if (watch->below ? value < watch->threshold :
+				   value > watch->threshold)
+			entry->samples++;
+		else
+			entry->samples = 0;
+		if (entry->samples < watch->count)
+			return 0;
+		entry->active = 1;
+	} else {
+		if (watch->below ? value <= watch->clear :
+				   value >= watch->clear)
+			return 0;
+		entry->active = 0;
+		entry->samples = 0;
+	}
+	return 1;
+}
+
+/* Make the descriptor readable, if there is one. Errors only mean that
+   it is readable already. */
+static void watch_signal(uint64_t count)
+{
+	ssize_t res;
+
+	if (watch_fd >= 0) {
+		res = write(watch_fd, &count, sizeof(count));
+		(void)res;
+	}
+}
+
+/* Queue an event, dropping the oldest one if the queue is full */
+static void watch_queue_event(const sensors_watch_event *event)
+{
+	if (watch_queue_count == WATCH_QUEUE_MAX) {
+		watch_queue_first = (watch_queue_first + 1) % WATCH_QUEUE_MAX;
+		watch_queue_count--;
+	}
+	watch_queue[(watch_queue_first + watch_queue_count) %
+		    WATCH_QUEUE_MAX] = *event;
+	watch_queue_count++;
+	watch_signal(1);
+}
+
+/* Evaluate all watches, with the values from a sample if value is not
+   NULL, from reads otherwise. Returns the number of transitions. */
+static int watch_eval(const double *value, const int *error,
+		      const sensors_watch_read *reads, int reads_count)
+{
+	sensors_watch_call *calls;
+	sensors_watch_entry *entry;
+	double val;
+	int i, r = 0, n = 0;
+
+	pthread_mutex_lock(&watch_lock);
+	calls = malloc((watches_count + 1) * sizeof(sensors_watch_call));
+	if (!calls)
+		sensors_fatal_error(__func__, "Out of memory");
+
+	for (i = 0; i < watches_count; i++) {
+		entry = &watches[i];
+		if (value) {
+			if (error[entry->flat] &&
+			    error[entry->flat] != -SENSORS_ERR_STALE)
+				continue;
+			val = value[entry->flat];
+		} else {
+			/* Both are sorted by id. Watches added since the
+			   reads have no value yet. */
+			while (r < reads_count && reads[r].id < entry->id)
+				r++;
+			if (r == reads_count || reads[r].id != entry->id ||
+			    reads[r].error)
+				continue;
+			val = reads[r].value;
+		}
+		if (!watch_feed(entry, val))
+			continue;
+
+		calls[n].event.chip = &entry->chip->chip;
+		calls[n].event.subfeature = entry->subfeature;
+		calls[n].event.id = entry->id;
+		calls[n].event.active = entry->active;
+		calls[n].event.value = val;
+		calls[n].fn = entry->fn;
+		calls[n].data = entry->data;
+		watch_queue_event(&calls[n].event);
+		n++;
+	}
+	pthread_mutex_unlock(&watch_lock);
+
+	for (i = 0; i < n; i++)
+		if (calls[i].fn)
+			calls[i].fn(&calls[i].event, calls[i].data);
+	free(calls);
+
+	return n;
+}
+
+int sensors_watch_update(void)
+{
+	sensors_watch_read *reads;
+	int i, count, n;
+
+	pthread_mutex_lock(&watch_lock);
+	count = watches_count;
+	if (!count) {
+		pthread_mutex_unlock(&watch_lock);
+		return 0;
+	}
+	reads = malloc(count * sizeof(sensors_watch_read));
+	if (!reads)
+		sensors_fatal_error(__func__, "Out of memory");
+	for (i = 0; i < count; i++) {
+		reads[i].id = watches[i].id;
+		reads[i].chip = watches[i].chip;
+		reads[i].subfeature = watches[i].subfeature;
+	}
+	pthread_mutex_unlock(&watch_lock);
+
+	for (i = 0; i < count; i++)
+		reads[i].error = sensors_compute_value(reads[i].chip,
+						       reads[i].subfeature,
+						       NULL, MAX_AGE_CHIP,
+						       &reads[i].value);
+
+	n = watch_eval(NULL, NULL, reads, count);
+	free(reads);
+	return n;
+}
+
+void sensors_watch_sample(const double *value, const int *error)
+{
+	watch_eval(value, error, NULL, 0);
+}
+
+int sensors_get_watch_fd(void)
+{
+	pthread_mutex_lock(&watch_lock);
+	if (watch_fd < 0) {
+		watch_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+		/* Events might be queued already */
+		if (watch_queue_count)
+			watch_signal(watch_queue_count);
+	}
+	pthread_mutex_unlock(&watch_lock);
+
+	return watch_fd >= 0 ? watch_fd : -SENSORS_ERR_KERNEL;
+}
+
+int sensors_read_watch_events(sensors_watch_event *events, int max)
+{
+	uint64_t count;
+	ssize_t res;
+	int n = 0;
+
+	pthread_mutex_lock(&watch_lock);
+	while (n < max && watch_queue_count) {
+		events[n++] = watch_queue[watch_queue_first];
+		watch_queue_first = (watch_queue_first + 1) % WATCH_QUEUE_MAX;
+		watch_queue_count--;
+	}
+	/* Only reset the descriptor once the queue is empty. An error only
+	   means that it was not readable. */
+	if (watch_fd >= 0 && !watch_queue_count) {
+		res = read(watch_fd, &count, sizeof(count));
+		(void)res;
+	}
+	pthread_mutex_unlock(&watch_lock);
+
+	return n;
+}
+
+void sensors_cleanup_watches(void)
+{
+	pthread_mutex_lock(&watch_lock);
+	free(watches);
+	watches = NULL;
+	watches_count = watches_max = 0;
+	watch_next_id = 0;
+	watch_queue_first = watch_queue_count = 0;
+	if (watch_fd >= 0) {
+		close(watch_fd);
+		watch_fd = -1;
+	}
+	pthread_mutex_unlock(&watch_lock);
+}
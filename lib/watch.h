@@ -0,0 +1,30 @@
+/*
+    watch.h - Part of libsensors, a Linux library for reading sensor data.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#ifndef LIB_SENSORS_WATCH_H
+#define LIB_SENSORS_WATCH_H
+
+/* Evaluate all watches with the values and errors of a sample, laid out
+   as the metrics of sensors_get_schema() */
+void sensors_watch_sample(const double *value, const int *error);
+
+/* Remove all watches and close the watch file descriptor */
+void sensors_cleanup_watches(void);
+
+#endif /* def LIB_SENSORS_WATCH_H */
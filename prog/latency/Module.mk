@@ -0,0 +1,54 @@
+#  Module.mk - Makefile for a Linux module for reading sensor data.
+#  Copyright (c) 1998, 1999  Frodo Looijaard <frodol@dds.nl>
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; either version 2 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+#  MA 02110-1301 USA.
+
+MODULE_DIR := prog/latency
+PROGLATENCYDIR := $(MODULE_DIR)
+
+PROGLATENCYMAN1DIR := $(MANDIR)/man1
+PROGLATENCYMAN1FILES := $(MODULE_DIR)/sensors-latency.1
+
+PROGLATENCYTARGETS := $(MODULE_DIR)/sensors-latency
+PROGLATENCYSOURCES := $(MODULE_DIR)/sensors-latency.c
+
+# Include all dependency files. We use '.rd' to indicate this will create
+# executables.
+INCLUDEFILES += $(PROGLATENCYSOURCES:.c=.rd)
+
+REMOVELATENCYBIN := $(patsubst $(MODULE_DIR)/%,$(DESTDIR)$(BINDIR)/%,$(PROGLATENCYTARGETS))
+REMOVELATENCYMAN := $(patsubst $(MODULE_DIR)/%,$(DESTDIR)$(PROGLATENCYMAN1DIR)/%,$(PROGLATENCYMAN1FILES))
+
+$(PROGLATENCYTARGETS): $(PROGLATENCYSOURCES:.c=.ro) lib/$(LIBSHBASENAME)
+	$(CC) $(EXLDFLAGS) -o $@ $(PROGLATENCYSOURCES:.c=.ro) -Llib -lsensors
+
+all-prog-latency: $(PROGLATENCYTARGETS)
+user :: all-prog-latency
+
+install-prog-latency: all-prog-latency
+	$(MKDIR) $(DESTDIR)$(BINDIR) $(DESTDIR)$(PROGLATENCYMAN1DIR)
+	$(INSTALL) -m 755 $(PROGLATENCYTARGETS) $(DESTDIR)$(BINDIR)
+	$(INSTALL) -m 644 $(PROGLATENCYMAN1FILES) $(DESTDIR)$(PROGLATENCYMAN1DIR)
+user_install :: install-prog-latency
+
+user_uninstall::
+	$(RM) $(REMOVELATENCYBIN)
+	$(RM) $(REMOVELATENCYMAN)
+
+clean-prog-latency:
+	$(RM) $(PROGLATENCYDIR)/*.rd $(PROGLATENCYDIR)/*.ro
+	$(RM) $(PROGLATENCYTARGETS)
+clean :: clean-prog-latency
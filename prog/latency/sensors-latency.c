@@ -0,0 +1,493 @@
+/*
+    sensors-latency.c - Part of lm_sensors, Linux kernel modules for
+                        hardware monitoring. Measure how long reading
+                        each attribute of each chip takes.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+/* Every readable subfeature of every chip is read once per pass, always
+   from the chip, bypassing the cache of the library. The latency
+   distribution of each attribute and of each chip is reported, with the
+   number of errors and of value changes. An attribute which didn't
+   change over a run at least as long as the update interval of its chip
+   is flagged as static: reading it again is a waste. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+#include "lib/sensors.h"
+#include "lib/error.h"
+#include "version.h"
+
+#define PROGRAM			"sensors-latency"
+#define VERSION			LM_VERSION
+
+#define DEFAULT_PASSES		100
+#define DEFAULT_INTERVAL	50	/* milliseconds */
+
+struct attr {
+	const sensors_subfeature *subfeature;
+	long long *ns;		/* latency of each successful read */
+	int reads;
+	int errors;
+	int changes;
+	int has_value;
+	double value;		/* last value read */
+};
+
+struct chip {
+	const sensors_chip_name *name;
+	char id[200];
+	int update_interval;	/* in milliseconds, -1 if unknown */
+	struct attr *attrs;
+	int count;
+};
+
+/* Latency distribution */
+struct dist {
+	int reads;
+	int errors;
+	long long min, median, p99, max;
+};
+
+static struct chip *chips;
+static int chips_count;
+static int passes = DEFAULT_PASSES;
+static long long span_ms;		/* from the first pass to the last */
+
+static void print_short_help(void)
+{
+	printf("Try `%s -h' for more information\n", PROGRAM);
+}
+
+static void print_long_help(void)
+{
+	printf("Usage: %s [OPTION]... [CHIP]...\n", PROGRAM);
+	puts("  -c, --config-file      Specify a config file\n"
+	     "  -n, --passes           Number of reads of each attribute (default 100)\n"
+	     "  -i, --interval         Milliseconds between passes (default 50)\n"
+	     "  -j                     Json output\n"
+	     "  -h, --help             Display this help text\n"
+	     "  -v, --version          Display the program version\n"
+	     "\n"
+	     "Use `-' after `-c' to read the config file from stdin.\n"
+	     "If no chips are specified, all chips are measured.");
+}
+
+static void print_version(void)
+{
+	printf("%s version %s with libsensors version %s\n", PROGRAM, VERSION,
+	       libsensors_version);
+}
+
+static void *xcalloc(size_t nmemb, size_t size)
+{
+	void *p = calloc(nmemb, size);
+
+	if (!p) {
+		perror("calloc");
+		exit(1);
+	}
+	return p;
+}
+
+static long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* The update interval of a chip isn't a subfeature, read it from sysfs */
+static int read_update_interval(const sensors_chip_name *name)
+{
+	char path[4096];
+	FILE *f;
+	int interval;
+
+	if (!name->path)	/* Virtual chip */
+		return -1;
+	snprintf(path, sizeof(path), "%s/update_interval", name->path);
+	if (!(f = fopen(path, "r")))
+		return -1;
+	if (fscanf(f, "%d", &interval) != 1)
+		interval = -1;
+	fclose(f);
+	return interval;
+}
+
+static void add_chip(const sensors_chip_name *name)
+{
+	const sensors_feature *feature;
+	const sensors_subfeature *sf;
+	struct chip *chip;
+	int f = 0, s;
+
+	chips = realloc(chips, (chips_count + 1) * sizeof(*chips));
+	if (!chips) {
+		perror("realloc");
+		exit(1);
+	}
+	chip = &chips[chips_count++];
+	memset(chip, 0, sizeof(*chip));
+	chip->name = name;
+	if (sensors_snprintf_chip_name(chip->id, sizeof(chip->id), name) < 0)
+		snprintf(chip->id, sizeof(chip->id), "%s", name->prefix);
+	chip->update_interval = read_update_interval(name);
+
+	while ((feature = sensors_get_features(name, &f))) {
+		s = 0;
+		while ((sf = sensors_get_all_subfeatures(name, feature, &s))) {
+			if (!(sf->flags & SENSORS_MODE_R))
+				continue;
+			chip->attrs = realloc(chip->attrs, (chip->count + 1) *
+					      sizeof(struct attr));
+			if (!chip->attrs) {
+				perror("realloc");
+				exit(1);
+			}
+			memset(&chip->attrs[chip->count], 0, sizeof(struct attr));
+			chip->attrs[chip->count].subfeature = sf;
+			chip->attrs[chip->count++].ns =
+				xcalloc(passes, sizeof(long long));
+		}
+	}
+}
+
+static void read_attr(const struct chip *chip, struct attr *attr)
+{
+	long long start, ns;
+	double value;
+	int err;
+
+	start = now_ns();
+	/* A max_age of 0 forces a read from the chip */
+	err = sensors_get_value_max_age(chip->name, attr->subfeature->number,
+					0, &value);
+	ns = now_ns() - start;
+
+	if (err) {
+		attr->errors++;
+		return;
+	}
+	attr->ns[attr->reads++] = ns;
+	if (attr->has_value && value != attr->value)
+		attr->changes++;
+	attr->value = value;
+	attr->has_value = 1;
+}
+
+static void run(int interval)
+{
+	struct timespec ts;
+	long long first = 0;
+	int p, c, a;
+
+	for (p = 0; p < passes; p++) {
+		if (p && interval) {
+			ts.tv_sec = interval / 1000;
+			ts.tv_nsec = (interval % 1000) * 1000000L;
+			nanosleep(&ts, NULL);
+		}
+		if (!p)
+			first = now_ns();
+		for (c = 0; c < chips_count; c++)
+			for (a = 0; a < chips[c].count; a++)
+				read_attr(&chips[c], &chips[c].attrs[a]);
+	}
+	span_ms = (now_ns() - first) / 1000000;
+}
+
+static int cmp_ll(const void *a, const void *b)
+{
+	long long x = *(const long long *)a, y = *(const long long *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* Sorts ns */
+static void get_dist(long long *ns, int count, struct dist *dist)
+{
+	if (!count) {
+		dist->min = dist->median = dist->p99 = dist->max = 0;
+		return;
+	}
+	qsort(ns, count, sizeof(long long), cmp_ll);
+	dist->min = ns[0];
+	dist->median = ns[(count - 1) / 2];
+	dist->p99 = ns[(int)((count - 1) * 0.99 + 0.5)];
+	dist->max = ns[count - 1];
+}
+
+static void get_attr_dist(struct attr *attr, struct dist *dist)
+{
+	dist->reads = attr->reads + attr->errors;
+	dist->errors = attr->errors;
+	get_dist(attr->ns, attr->reads, dist);
+}
+
+static void get_chip_dist(const struct chip *chip, struct dist *dist)
+{
+	long long *ns;
+	int a, n = 0;
+
+	dist->reads = dist->errors = 0;
+	ns = xcalloc(chip->count * passes + 1, sizeof(long long));
+	for (a = 0; a < chip->count; a++) {
+		memcpy(ns + n, chip->attrs[a].ns,
+		       chip->attrs[a].reads * sizeof(long long));
+		n += chip->attrs[a].reads;
+		dist->reads += chip->attrs[a].reads + chip->attrs[a].errors;
+		dist->errors += chip->attrs[a].errors;
+	}
+	get_dist(ns, n, dist);
+	free(ns);
+}
+
+/* Whether an attribute didn't change for at least the update interval
+   of its chip, or -1 if we can't tell because the update interval is
+   unknown */
+static int is_static(const struct chip *chip, const struct attr *attr)
+{
+	if (chip->update_interval < 0)
+		return -1;
+	return attr->reads >= 2 && !attr->changes &&
+	       span_ms >= chip->update_interval;
+}
+
+static void print_dist_text(const char *name, const struct dist *dist)
+{
+	printf("  %-20s %6d %6d %9.1f %9.1f %9.1f %9.1f", name, dist->reads,
+	       dist->errors, dist->min / 1000.0, dist->median / 1000.0,
+	       dist->p99 / 1000.0, dist->max / 1000.0);
+}
+
+static void print_text(void)
+{
+	struct dist dist;
+	struct attr *attr;
+	int c, a;
+
+	for (c = 0; c < chips_count; c++) {
+		printf("%s", chips[c].id);
+		if (chips[c].update_interval >= 0)
+			printf(" (update interval %d ms)",
+			       chips[c].update_interval);
+		printf("\n  %-20s %6s %6s %9s %9s %9s %9s %s\n", "ATTRIBUTE",
+		       "READS", "ERRORS", "MIN(us)", "MEDIAN", "P99", "MAX",
+		       "CHANGES");
+		for (a = 0; a < chips[c].count; a++) {
+			attr = &chips[c].attrs[a];
+			get_attr_dist(attr, &dist);
+			print_dist_text(attr->subfeature->name, &dist);
+			if (is_static(&chips[c], attr) == 1)
+				printf(" static\n");
+			else
+				printf(" %d\n", attr->changes);
+		}
+		get_chip_dist(&chips[c], &dist);
+		print_dist_text("(all)", &dist);
+		printf("\n\n");
+	}
+}
+
+static void print_dist_json(const struct dist *dist)
+{
+	printf("\"reads\":%d,\"errors\":%d,\"min_us\":%.1f,\"median_us\":%.1f,"
+	       "\"p99_us\":%.1f,\"max_us\":%.1f", dist->reads, dist->errors,
+	       dist->min / 1000.0, dist->median / 1000.0, dist->p99 / 1000.0,
+	       dist->max / 1000.0);
+}
+
+static void print_json(void)
+{
+	static const char *const static_str[] = { "null", "false", "true" };
+	struct dist dist;
+	struct attr *attr;
+	int c, a;
+
+	printf("{\n");
+	for (c = 0; c < chips_count; c++) {
+		printf("   \"%s\":{\n      \"update_interval_ms\":", chips[c].id);
+		if (chips[c].update_interval >= 0)
+			printf("%d,\n      ", chips[c].update_interval);
+		else
+			printf("null,\n      ");
+		get_chip_dist(&chips[c], &dist);
+		print_dist_json(&dist);
+		printf(",\n      \"attributes\":{\n");
+		for (a = 0; a < chips[c].count; a++) {
+			attr = &chips[c].attrs[a];
+			get_attr_dist(attr, &dist);
+			printf("         \"%s\":{", attr->subfeature->name);
+			print_dist_json(&dist);
+			printf(",\"changes\":%d,\"static\":%s}%s\n",
+			       attr->changes,
+			       static_str[is_static(&chips[c], attr) + 1],
+			       a < chips[c].count - 1 ? "," : "");
+		}
+		printf("      }\n   }%s\n", c < chips_count - 1 ? "," : "");
+	}
+	printf("}\n");
+}
+
+/* Return 0 on success, and an exit error code otherwise */
+static int read_config_file(const char *config_file_name)
+{
+	FILE *config_file;
+	int err;
+
+	if (config_file_name) {
+		if (!strcmp(config_file_name, "-"))
+			config_file = stdin;
+		else
+			config_file = fopen(config_file_name, "r");
+
+		if (!config_file) {
+			fprintf(stderr, "Could not open config file\n");
+			perror(config_file_name);
+			return 1;
+		}
+	} else {
+		/* Use libsensors default */
+		config_file = NULL;
+	}
+
+	err = sensors_init(config_file);
+	if (err) {
+		fprintf(stderr, "sensors_init: %s\n", sensors_strerror(err));
+		if (config_file)
+			fclose(config_file);
+		return 1;
+	}
+
+	if (config_file && fclose(config_file) == EOF)
+		perror(config_file_name);
+
+	return 0;
+}
+
+static void add_chips(const sensors_chip_name *match)
+{
+	const sensors_chip_name *name;
+	int nr = 0;
+
+	while ((name = sensors_get_detected_chips(match, &nr)))
+		add_chip(name);
+}
+
+int main(int argc, char *argv[])
+{
+	int c, i, err, do_json = 0, interval = DEFAULT_INTERVAL;
+	const char *config_file_name = NULL;
+	sensors_chip_name match;
+
+	struct option long_opts[] =  {
+		{ "help", no_argument, NULL, 'h' },
+		{ "version", no_argument, NULL, 'v'},
+		{ "config-file", required_argument, NULL, 'c' },
+		{ "passes", required_argument, NULL, 'n' },
+		{ "interval", required_argument, NULL, 'i' },
+		{ 0, 0, 0, 0 }
+	};
+
+	while ((c = getopt_long(argc, argv, "hvc:n:i:j", long_opts, NULL))
+	       != EOF) {
+		switch (c) {
+		case ':':
+		case '?':
+			print_short_help();
+			exit(1);
+		case 'h':
+			print_long_help();
+			exit(0);
+		case 'v':
+			print_version();
+			exit(0);
+		case 'c':
+			config_file_name = optarg;
+			break;
+		case 'n':
+			passes = atoi(optarg);
+			if (passes < 1) {
+				fprintf(stderr, "Invalid number of passes\n");
+				exit(1);
+			}
+			break;
+		case 'i':
+			interval = atoi(optarg);
+			if (interval < 0) {
+				fprintf(stderr, "Invalid interval\n");
+				exit(1);
+			}
+			break;
+		case 'j':
+			do_json = 1;
+			break;
+		default:
+			fprintf(stderr,
+				"Internal error while parsing options!\n");
+			exit(1);
+		}
+	}
+
+	err = read_config_file(config_file_name);
+	if (err)
+		exit(err);
+
+	if (optind == argc) {
+		add_chips(NULL);
+	} else {
+		for (i = optind; i < argc; i++) {
+			if (sensors_parse_chip_name(argv[i], &match)) {
+				fprintf(stderr,
+					"Parse error in chip name `%s'\n",
+					argv[i]);
+				print_short_help();
+				err = 1;
+				goto exit;
+			}
+			add_chips(&match);
+			sensors_free_chip_name(&match);
+		}
+	}
+	if (!chips_count) {
+		fprintf(stderr, "No sensors found!\n");
+		err = 1;
+		goto exit;
+	}
+
+	run(interval);
+	if (do_json)
+		print_json();
+	else
+		print_text();
+
+	for (c = 0; c < chips_count; c++) {
+		for (i = 0; i < chips[c].count; i++)
+			free(chips[c].attrs[i].ns);
+		free(chips[c].attrs);
+	}
+	free(chips);
+
+exit:
+	sensors_cleanup();
+	exit(err);
+}
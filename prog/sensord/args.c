@@ -93,6 +93,8 @@ static const char *daemonSyntax =
 	"  -i, --interval <time>     -- interval between scanning alarms (default 60s)\n"
 	"  -l, --log-interval <time> -- interval between logging sensors (default 30m)\n"
 	"  -t, --rrd-interval <time> -- interval between updating RRD file (default 5m)\n"
+	"  -P, --publish-interval <time> -- interval between publishing sensors\n"
+	"                               to shared memory (default 0)\n"
 	"  -1, --oneline             -- log chip, adapter, and sensor data on one line\n"
 	"  -T, --rrd-no-average      -- switch RRD in non-average mode\n"
 	"  -r, --rrd-file <file>     -- RRD file (default <none>)\n"
@@ -117,12 +119,13 @@ static const char *daemonSyntax =
 	"the RRD file configuration must EXACTLY match the sensors that are used. If\n"
 	"your configuration changes, delete the old RRD file and restart sensord.\n";
 
-static const char *shortOptions = "i:l:t:1Tf:r:c:p:advhg:";
+static const char *shortOptions = "i:l:t:P:1Tf:r:c:p:advhg:";
 
 static const struct option longOptions[] = {
 	{ "interval", required_argument, NULL, 'i' },
 	{ "log-interval", required_argument, NULL, 'l' },
 	{ "rrd-interval", required_argument, NULL, 't' },
+	{ "publish-interval", required_argument, NULL, 'P' },
 	{ "oneline", no_argument, NULL, '1' },
 	{ "rrd-no-average", no_argument, NULL, 'T' },
 	{ "syslog-facility", required_argument, NULL, 'f' },
@@ -163,6 +166,10 @@ int parseArgs(int argc, char **argv)
 			if ((sensord_args.rrdTime = parseTime(optarg)) < 0)
 				return -1;
 			break;
+		case 'P':
+			if ((sensord_args.publishTime = parseTime(optarg)) < 0)
+				return -1;
+			break;
 		case '1':
 			sensord_args.logOneline = 1;
 			break;
@@ -225,9 +232,9 @@ int parseArgs(int argc, char **argv)
 	}
 
 	if (!sensord_args.logTime && !sensord_args.scanTime &&
-	    !sensord_args.rrdFile) {
+	    !sensord_args.rrdFile && !sensord_args.publishTime) {
 		fprintf(stderr,
-			"Error: No logging, alarm or RRD scanning.\n");
+			"Error: No logging, alarm, RRD scanning or publishing.\n");
 		return -1;
 	}
 
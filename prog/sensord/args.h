@@ -16,6 +16,7 @@ struct sensord_arguments {
 	int logOneline;
 	int rrdTime;
 	int rrdNoAverage;
+	int publishTime;
 	int syslogFacility;
 	int doScan;
 	int doSet;
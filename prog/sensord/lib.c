@@ -78,12 +78,23 @@ static int loadConfig(const char *cfgPath, int reload)
  	return 0;
 }
 
+/*
+ * The alarm, log and RRD passes often run at the same time, so let them
+ * share the values as long as the drivers did not refresh them.
+ */
+static void enableCache(void)
+{
+	sensors_set_cache_max_age(NULL, SENSORS_CACHE_UPDATE_INTERVAL);
+}
+
 int loadLib(const char *cfgPath)
 {
 	int ret;
 	ret = loadConfig(cfgPath, 0);
-	if (!ret)
+	if (!ret) {
+		enableCache();
 		ret = initKnownChips();
+	}
 	return ret;
 }
 
@@ -92,8 +103,10 @@ int reloadLib(const char *cfgPath)
 	int ret;
 	freeKnownChips();
 	ret = loadConfig(cfgPath, 1);
-	if (!ret)
+	if (!ret) {
+		enableCache();
 		ret = initKnownChips();
+	}
 	return ret;
 }
 
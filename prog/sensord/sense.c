@@ -254,12 +254,73 @@ int readChips(void)
 	return ret;
 }
 
+static int isSelected(const sensors_chip_name *chip)
+{
+	const sensors_chip_name *match;
+	int i, j;
+
+	for (j = 0; j < sensord_args.numChipNames; j++) {
+		i = 0;
+		while ((match = sensors_get_detected_chips(
+					&sensord_args.chipNames[j], &i)))
+			if (match == chip)
+				return 1;
+	}
+	return 0;
+}
+
+static int scanAlarm(const sensors_chip_name *chip,
+		     const sensors_subfeature *sub)
+{
+	const FeatureDescriptor *features;
+	int i, j;
+
+	for (i = 0; knownChips[i].features; i++) {
+		/* Same address trick as in doChip() */
+		if (knownChips[i].name != chip)
+			continue;
+		features = knownChips[i].features;
+		for (j = 0; features[j].format; j++)
+			if (features[j].alarmNumber == sub->number)
+				return do_features(chip, features + j, DO_SCAN);
+	}
+	return 0;
+}
+
+/* Read all alarms at once, and only look at the features which alarm */
 int scanChips(void)
 {
-	int ret = 0;
+	const sensors_chip_name *chip;
+	const sensors_subfeature *sub;
+	unsigned long *alarms;
+	int nr, ret;
 
 	sensorLog(LOG_DEBUG, "sensor sweep started");
-	ret = doChips(DO_SCAN);
+
+	alarms = malloc(SENSORS_ALARM_LONGS(sensors_get_alarm_count() + 1) *
+			sizeof(unsigned long));
+	if (!alarms) {
+		sensorLog(LOG_ERR, "Out of memory");
+		return 1;
+	}
+
+	ret = sensors_read_alarms(alarms);
+	if (ret < 0) {
+		sensorLog(LOG_ERR, "Error reading alarms: %s",
+			  sensors_strerror(ret));
+	} else {
+		ret = 0;
+		nr = 0;
+		while ((sub = sensors_get_next_alarm(alarms, &nr, &chip, NULL))) {
+			if (!isSelected(chip))
+				continue;
+			ret = scanAlarm(chip, sub);
+			if (ret)
+				break;
+		}
+	}
+	free(alarms);
+
 	sensorLog(LOG_DEBUG, "sensor sweep finished");
 
 	return ret;
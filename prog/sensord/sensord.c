@@ -30,11 +30,13 @@
 #include <syslog.h>
 #include <unistd.h>
 #include <time.h>
+#include <poll.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
 #include "args.h"
 #include "sensord.h"
+#include "lib/error.h"
 
 static int logOpened = 0;
 
@@ -75,10 +77,59 @@ static void signalHandler(int sig)
 	}
 }
 
+static long long monotonicMs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+/*
+ * Sleep for the given number of seconds, or until the kernel notifies that
+ * an alarm was raised, in which case alarmed is set. Returns the number of
+ * whole seconds slept; the remaining milliseconds are carried over to the
+ * next call, so that waking up early doesn't delay the schedule.
+ */
+static int waitForAlarms(int sleepTime, int *alarmed)
+{
+	static long long carried;	/* milliseconds slept, not reported */
+	sensors_alarm_event events[16];
+	struct pollfd pfd;
+	long long start, slept, timeout;
+	int i, n;
+
+	pfd.fd = sensord_args.scanTime ? sensors_get_alarm_fd() : -1;
+	if (pfd.fd < 0) {
+		sleep(sleepTime);
+		return sleepTime;
+	}
+
+	timeout = sleepTime * 1000LL - carried;
+	if (timeout < 0)
+		timeout = 0;
+
+	start = monotonicMs();
+	pfd.events = POLLIN;
+	if (poll(&pfd, 1, timeout) > 0) {
+		n = sensors_read_alarm_events(events, ARRAY_SIZE(events));
+		for (i = 0; i < n; i++) {
+			sensorLog(LOG_DEBUG, "alarm %s changed to %d",
+				  events[i].subfeature->name, events[i].value);
+			if (events[i].value)
+				*alarmed = 1;
+		}
+	}
+
+	slept = monotonicMs() - start + carried;
+	carried = slept % 1000;
+	return slept / 1000;
+}
+
 static int sensord(void)
 {
 	int ret = 0;
-	int scanValue = 0, logValue = 0;
+	int scanValue = 0, logValue = 0, publishValue = 0;
 	/*
 	 * First RRD update at next RRD timeslot to prevent failures due
 	 * one timeslot updated twice on restart for example.
@@ -96,6 +147,13 @@ static int sensord(void)
 					  " error");
 			reload = 0;
 		}
+		if (sensord_args.publishTime && (publishValue <= 0)) {
+			if ((ret = sensors_shm_publish(sensord_args.publishTime
+						       * 1000)))
+				sensorLog(LOG_NOTICE, "sensor publish error"
+					  " (%s)", sensors_strerror(ret));
+			publishValue += sensord_args.publishTime;
+		}
 		if (sensord_args.scanTime && (scanValue <= 0)) {
 			if ((ret = scanChips()))
 				sensorLog(LOG_NOTICE,
@@ -126,12 +184,21 @@ static int sensord(void)
 			int b = sensord_args.scanTime ? scanValue : INT_MAX;
 			int c = (sensord_args.rrdTime && sensord_args.rrdFile)
 				? rrdValue : INT_MAX;
+			int d = sensord_args.publishTime ? publishValue
+				: INT_MAX;
 			int sleepTime = (a < b) ? ((a < c) ? a : c) :
 				((b < c) ? b : c);
-			sleep(sleepTime);
+			int alarmed = 0;
+
+			if (d < sleepTime)
+				sleepTime = d;
+			sleepTime = waitForAlarms(sleepTime, &alarmed);
 			scanValue -= sleepTime;
 			logValue -= sleepTime;
 			rrdValue -= sleepTime;
+			publishValue -= sleepTime;
+			if (alarmed)
+				scanValue = 0;
 		}
 	}
 
@@ -59,8 +59,8 @@ void print_chip_raw(const sensors_chip_name *name)
 		b = 0;
 		while ((sub = sensors_get_all_subfeatures(name, feature, &b))) {
 			if (sub->flags & SENSORS_MODE_R) {
-				if ((err = sensors_get_value(name, sub->number,
-							     &val)))
+				err = sensors_get_value(name, sub->number, &val);
+				if (err && err != -SENSORS_ERR_STALE)
 					fprintf(stderr, "ERROR: Can't get "
 						"value of subfeature %s: %s\n",
 						sub->name,
@@ -101,8 +101,8 @@ void print_chip_json(const sensors_chip_name *name)
 		subCnt = 0;
 		while ((sub = sensors_get_all_subfeatures(name, feature, &b))) {
 			if (sub->flags & SENSORS_MODE_R) {
-				if ((err = sensors_get_value(name, sub->number,
-							     &val))) {
+				err = sensors_get_value(name, sub->number, &val);
+				if (err && err != -SENSORS_ERR_STALE) {
 					fprintf(stderr, "ERROR: Can't get "
 						"value of subfeature %s: %s\n",
 						sub->name,
@@ -144,9 +144,10 @@ static double get_value(const sensors_chip_name *name,
 	int err;
 
 	err = sensors_get_value(name, sub->number, &val);
-	if (err) {
-		fprintf(stderr, "ERROR: Can't get value of subfeature %s: %s\n",
-			sub->name, sensors_strerror(err));
+	if (err && err != -SENSORS_ERR_STALE) {
+		if (err != -SENSORS_ERR_SUSPENDED)
+			fprintf(stderr, "ERROR: Can't get value of subfeature "
+				"%s: %s\n", sub->name, sensors_strerror(err));
 		val = 0;
 	}
 	return val;
@@ -160,7 +161,10 @@ static int get_input_value(const sensors_chip_name *name,
 	int err;
 
 	err = sensors_get_value(name, sub->number, val);
-	if (err && err != -SENSORS_ERR_ACCESS_R) {
+	if (err == -SENSORS_ERR_STALE)
+		return 0;	/* Device suspended, show the last value */
+	if (err && err != -SENSORS_ERR_ACCESS_R &&
+	    err != -SENSORS_ERR_SUSPENDED) {
 		fprintf(stderr, "ERROR: Can't get value of subfeature %s: %s\n",
 			sub->name, sensors_strerror(err));
 	}